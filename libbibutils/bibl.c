@@ -59,8 +59,10 @@ void
 bibl_free( bibl *b )
 {
 	long i;
-	for ( i=0; i<b->nrefs; ++i )
+	for ( i=0; i<b->nrefs; ++i ) {
 		fields_free( b->ref[i] );
+		free( b->ref[i] );
+	}
 	free( b->ref );
 	b->nrefs = b->maxrefs = 0;
 }
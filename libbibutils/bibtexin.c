@@ -12,6 +12,7 @@
 #include <ctype.h>
 #include "is_ws.h"
 #include "strsearch.h"
+#include "strhash.h"
 #include "newstr.h"
 #include "newstr_conv.h"
 #include "fields.h"
@@ -24,9 +25,58 @@
 extern lists asis;
 extern lists corps;
 
+/* @string definitions, kept for the life of the process as bibutils
+ * always has.  Shared by every read, so BibTeX must only ever be read
+ * on one thread at a time.
+ */
 lists find    = { 0, 0, NULL };
 lists replace = { 0, 0, NULL };
 
+/* @string names are hashed (case-insensitively) into chains that run
+ * from the newest definition back through find_next[]
+ */
+static int *find_hash = NULL, *find_next = NULL;
+static int  find_nhash = 0, find_maxnext = 0;
+
+static int
+find_rehash( int nhash )
+{
+	int *newhash, i, h;
+	newhash = (int *) malloc( sizeof( int ) * nhash );
+	if ( !newhash ) return 0;
+	for ( i=0; i<nhash; ++i ) newhash[i] = -1;
+	for ( i=0; i<find.n; ++i ) {
+		h = strcasehash( find.str[i].data ) & ( nhash-1 );
+		find_next[i] = newhash[h];
+		newhash[h] = i;
+	}
+	if ( find_hash ) free( find_hash );
+	find_hash = newhash;
+	find_nhash = nhash;
+	return 1;
+}
+
+static void
+find_index( int n )
+{
+	int *more, alloc, h;
+	if ( n >= find_maxnext ) {
+		alloc = ( find_maxnext ) ? find_maxnext * 2 : 64;
+		more = (int *) realloc( find_next, sizeof( int ) * alloc );
+		if ( !more ) return;
+		find_next = more;
+		find_maxnext = alloc;
+	}
+	if ( n >= find_nhash ) {
+		/* rehash covers entry n too */
+		find_rehash( ( find_nhash ) ? find_nhash * 2 : 64 );
+		return;
+	}
+	h = strcasehash( find.str[n].data ) & ( find_nhash-1 );
+	find_next[n] = find_hash[h];
+	find_hash[h] = n;
+}
+
 /*
  * readf can "read too far", so we store this information in line, thus
  * the next new text is in line, either from having read too far or
@@ -78,6 +128,7 @@ bibtex_item( char *p, newstr *s )
 {
 	int nquotes = 0;
 	int nbrackets = 0;
+	char *q;
 	while ( *p ) {
 		if ( !nquotes && !nbrackets ) {
 			if ( /*is_ws( *p ) ||*/ *p==',' || *p=='=' || *p=='}' || *p==')' )
@@ -92,9 +143,16 @@ bibtex_item( char *p, newstr *s )
 		} else if ( *p=='}' ) {
 			nbrackets--;
 			/*if ( nbrackets>0 )*/ newstr_addchar( s, *p );
+		} else if ( s->len==0 && is_ws( *p ) ) {
+			/* skip leading whitespace */
 		} else {
-			if ( s->len!=0 || ( s->len==0 && !is_ws( *p ) ) )
-				newstr_addchar( s, *p );
+			/* copy the run up to the next character of interest */
+			q = p + 1;
+			while ( *q && *q!='\"' && *q!='{' && *q!='}' &&
+				*q!=',' && *q!='=' && *q!=')' ) q++;
+			newstr_memcat( s, p, q - p );
+			p = q;
+			continue;
 		}
 		p++;
 	}
@@ -160,11 +218,18 @@ bibtex_addstring( char *p )
 	while ( is_ws( *p ) ) p++;
 	if ( *p=='(' || *p=='{' ) p++;
 	p = process_bibtexline( p, &s1, &s2 );
-	lists_add( &find, s1.data );
 	newstr_findreplace( &s2, "\\ ", " " );
 /*	newstr_findreplace( &s2, "\&", "&" );*/
 	bibtex_cleantoken( &s2 );
-	lists_add( &replace, s2.data );
+	if ( s1.data && lists_add( &find, s1.data ) ) {
+		if ( lists_add( &replace, s2.data ? s2.data : "" ) )
+			find_index( find.n-1 );
+		else {
+			/* keep find and replace in step */
+			find.n--;
+			newstr_empty( &(find.str[find.n]) );
+		}
+	}
 /*	if ( verbose ) {
 		fprintf( stderr, "String replacement: '%s' = '%s'\n",
 				s1.data, s2.data );
@@ -184,14 +249,12 @@ bibtex_protected( newstr *data )
 static void
 bibtex_removeprotection( newstr *data )
 {
-	newstr s;
 	if ( data->len<3 ) newstr_empty( data ); /* "", {} to nothing */
 	else {
-		newstr_init( &s );
-		newstr_segcpy( &s, &(data->data[1]), 
-				&(data->data[data->len-1]) );
-		newstr_newstrcpy( data, &s );
-		newstr_free( &s );
+		/* strip in place */
+		data->len -= 2;
+		memmove( data->data, &(data->data[1]), data->len );
+		data->data[data->len] = '\0';
 	}
 }
 
@@ -201,7 +264,9 @@ bibtex_split( lists *tokens, newstr *s )
 	newstr currtok;
 	int nquotes = 0, nbrackets = 0;
 	int i, n = s->len;
+	char buf[512] = "";
 	newstr_init( &currtok );
+	newstr_borrow( &currtok, buf, sizeof( buf ) );
 	for ( i=0; i<n; ++i ) {
 		if ( s->data[i]=='\"' ) {
 			if ( nquotes ) nquotes = 0;
@@ -230,15 +295,17 @@ bibtex_split( lists *tokens, newstr *s )
 static int
 bibtex_usestrings( newstr *s )
 {
-	int i;
-	for ( i=0; i<find.n; ++i ) {
-		if ( !strcasecmp( s->data, (find.str[i]).data ) ) {
-			newstr_findreplace( s, (find.str[i]).data, 
-					(replace.str[i]).data );
-			return 1;
-		}
+	int i, found = -1;
+	if ( !find_nhash ) return 0;
+	/* the first definition of a name wins */
+	i = find_hash[ strcasehash( s->data ) & ( find_nhash-1 ) ];
+	for ( ; i!=-1; i=find_next[i] ) {
+		if ( !strcasecmp( s->data, (find.str[i]).data ) ) found = i;
 	}
-	return 0;
+	if ( found==-1 ) return 0;
+	newstr_findreplace( s, (find.str[found]).data, 
+			(replace.str[found]).data );
+	return 1;
 }
 
 /* get reference type */
@@ -246,12 +313,15 @@ static char*
 process_bibtextype( char *p, newstr *data )
 {
 	newstr tmp;
+	char *q;
 	newstr_init( &tmp );
 
 	newstr_empty( data );
 
 	if ( *p=='@' ) p++; /* skip '@' character */
-	while ( *p && *p!='{' && *p!='(' ) newstr_addchar( &tmp, *p++ );
+	q = p + strcspn( p, "{(" );
+	if ( q > p ) newstr_segcpy( &tmp, p, q );
+	p = q;
 	if ( *p=='{' || *p=='(' ) p++;
 	if ( is_ws( *p ) ) p++;
 
@@ -269,11 +339,13 @@ static char*
 process_bibtexid( char *p, newstr *data )
 {
 	newstr tmp;
-	char *start_p = p;
+	char *start_p = p, *q;
 	newstr_init( &tmp );
 	newstr_empty( data );
 
-	while ( *p && *p!=',' ) newstr_addchar( &tmp, *p++ );
+	q = p + strcspn( p, "," );
+	if ( q > p ) newstr_segcpy( &tmp, p, q );
+	p = q;
 	if ( *p==',' ) p++;
 	if ( is_ws( *p ) ) p++; /* skip ending newline/carriage return */
 
@@ -361,37 +433,94 @@ bibtex_addtitleurl( fields *info, newstr *in )
 	newstr_free( &s );
 }
 
+/* tokens is scratch space, emptied here; passing the same list for
+ * every value keeps its strings allocated between calls
+ */
 static void
-bibtex_cleandata( newstr *s, fields *info )
+bibtex_cleandata( newstr *s, fields *info, lists *tokens )
 {
-	lists tokens = { 0, 0, NULL };
 	int i;
 	if ( !s->len ) return;
-	bibtex_split( &tokens, s );
-	for ( i=0; i<tokens.n; ++i ) {
-		if ( !bibtex_protected( &(tokens.str[i] ) ) ) {
-			bibtex_usestrings( &(tokens.str[i]) );
+	lists_empty( tokens );
+	bibtex_split( tokens, s );
+	for ( i=0; i<tokens->n; ++i ) {
+		if ( !bibtex_protected( &(tokens->str[i] ) ) ) {
+			bibtex_usestrings( &(tokens->str[i]) );
 		} else {
-			if (!strncasecmp(tokens.str[i].data,"\\href{", 6)) {
-				bibtex_addtitleurl( info, &(tokens.str[i]) );
+			if (!strncasecmp(tokens->str[i].data,"\\href{", 6)) {
+				bibtex_addtitleurl( info, &(tokens->str[i]) );
 			}
-			bibtex_cleantoken( &(tokens.str[i]) );
+			bibtex_cleantoken( &(tokens->str[i]) );
 		}
 	}
 	newstr_empty( s );
-	for ( i=0; i<tokens.n; ++i ) {
-		if ( bibtex_protected( &(tokens.str[i]) ) )
-			bibtex_removeprotection( &(tokens.str[i]));
-		newstr_strcat( s, tokens.str[i].data ); 
+	for ( i=0; i<tokens->n; ++i ) {
+		if ( bibtex_protected( &(tokens->str[i]) ) )
+			bibtex_removeprotection( &(tokens->str[i]));
+		newstr_strcat( s, tokens->str[i].data ); 
 	}
-	lists_free( &tokens );
 }
 
+/* refindex
+ *
+ * citekey -> reference lookup for crossref resolution, built once
+ * per bibl instead of scanning every reference for every crossref
+ */
+typedef struct refindex {
+	long *hash, *next;
+	char **key;
+	long nhash;
+} refindex;
+
+static void
+refindex_free( refindex *r )
+{
+	if ( r->hash ) free( r->hash );
+	if ( r->next ) free( r->next );
+	if ( r->key ) free( r->key );
+	r->hash = r->next = NULL;
+	r->key = NULL;
+	r->nhash = 0;
+}
+
+static void
+refindex_init( refindex *r, bibl *bin )
+{
+	long i, h;
+	int n;
+	r->nhash = 64;
+	while ( r->nhash < bin->nrefs ) r->nhash *= 2;
+	r->hash = (long *) malloc( sizeof( long ) * r->nhash );
+	r->next = (long *) malloc( sizeof( long ) * ( bin->nrefs + 1 ) );
+	r->key  = (char **) malloc( sizeof( char * ) * ( bin->nrefs + 1 ) );
+	if ( !r->hash || !r->next || !r->key ) {
+		refindex_free( r );
+		return;
+	}
+	for ( i=0; i<r->nhash; ++i ) r->hash[i] = -1;
+	/* insert newest first so chains run in file order */
+	for ( i=bin->nrefs-1; i>=0; --i ) {
+		n = fields_find( bin->ref[i], "refnum", -1 );
+		r->key[i] = ( n==-1 ) ? NULL : bin->ref[i]->data[n].data;
+		if ( !r->key[i] ) continue;
+		h = strhash( r->key[i] ) & ( r->nhash-1 );
+		r->next[i] = r->hash[h];
+		r->hash[h] = i;
+	}
+}
+
+/* falls back to a scan if the index couldn't be allocated */
 static long
-bibtexin_findref( bibl *bin, char *citekey )
+bibtexin_findref( bibl *bin, refindex *r, char *citekey )
 {
 	int n;
 	long i;
+	if ( r->nhash ) {
+		i = r->hash[ strhash( citekey ) & ( r->nhash-1 ) ];
+		for ( ; i!=-1; i=r->next[i] )
+			if ( !strcmp( r->key[i], citekey ) ) return i;
+		return -1;
+	}
 	for ( i=0; i<bin->nrefs; ++i ) {
 		n = fields_find( bin->ref[i], "refnum", -1 );
 		if ( n==-1 ) continue;
@@ -406,11 +535,16 @@ bibtexin_crossref( bibl *bin )
 	char booktitle[] = "booktitle";
 	long i, j, ncross;
 	char *nt, *nd, *type;
-	int n, ntype, nl;
+	int n, ntype, nl, indexed = 0;
+	refindex r;
         for ( i=0; i<bin->nrefs; ++i ) {
 		n = fields_find( bin->ref[i], "CROSSREF", -1 );
 		if ( n==-1 ) continue;
-		ncross = bibtexin_findref( bin, bin->ref[i]->data[n].data );
+		if ( !indexed ) {
+			refindex_init( &r, bin );
+			indexed = 1;
+		}
+		ncross = bibtexin_findref( bin, &r, bin->ref[i]->data[n].data );
 		if ( ncross==-1 ) {
 			int n1 = fields_find( bin->ref[i], "REFNUM", -1 );
 			fprintf( stderr, "Cannot find cross-reference '%s'",
@@ -441,17 +575,18 @@ bibtexin_crossref( bibl *bin )
 
 		}
 	}
+	if ( indexed ) refindex_free( &r );
 }
 
 static void
-bibtexin_cleanref( fields *bibin )
+bibtexin_cleanref( fields *bibin, lists *tokens )
 {
 	newstr *t, *d;
 	int i;
 	for ( i=0; i<bibin->nfields; ++i ) {
 		t = &( bibin->tag[i] );
 		d = &( bibin->data[i] );
-		bibtex_cleandata( d, bibin );
+		bibtex_cleandata( d, bibin, tokens );
 		if ( !strsearch( t->data, "AUTHORS" ) ) {
 			newstr_findreplace( d, "\n", " " );
 			newstr_findreplace( d, "\r", " " );
@@ -468,9 +603,12 @@ bibtexin_cleanref( fields *bibin )
 void
 bibtexin_cleanf( bibl *bin )
 {
+	lists tokens;
 	long i;
+	lists_init( &tokens );
         for ( i=0; i<bin->nrefs; ++i )
-		bibtexin_cleanref( bin->ref[i] );
+		bibtexin_cleanref( bin->ref[i], &tokens );
+	lists_free( &tokens );
 	bibtexin_crossref( bin );
 }
 
@@ -28,6 +28,7 @@
 #include "wordout.h"
 #include "newstr_conv.h"
 #include "is_ws.h"
+#include "strhash.h"
 
 typedef struct convert_rules {
 	int  (*readf)(FILE*,char*,int,int*,newstr*,newstr*,int*);
@@ -58,6 +59,7 @@ bibl_initparams( param *p, int readmode, int writemode )
 	p->verbose          = 0;
 	p->addcount         = 0;
 	p->singlerefperfile = 0;
+	p->readpart         = 0;
 	p->output_raw       = 0;	/* keep MODS tags for output filter */
 
 	if ( readmode == BIBL_BIBTEXIN ) {
@@ -341,31 +343,31 @@ resolve_citekeys( bibl *b, lists *citekeys, int *dup )
 {
 	char abc[]="abcdefghijklmnopqrstuvwxyz";
 	newstr tmp;
-	int nsame, ntmp, n, i, j;
+	int nsame, ntmp, n, j, *count;
 
+	count = ( int * ) calloc( citekeys->n, sizeof( int ) );
+	if ( !count ) return;
 	newstr_init( &tmp );
 
-	for ( i=0; i<citekeys->n; ++i ) {
-		if ( dup[i]==-1 ) continue;
-		nsame = 0;
-		for ( j=i; j<citekeys->n; ++j ) {
-			if ( dup[j]!=i ) continue;
-			newstr_strcpy( &tmp, citekeys->str[j].data );
-			ntmp = nsame;
-			while ( ntmp >= 26 ) {
-				newstr_addchar( &tmp, 'a' );
-					ntmp -= 26;
-			}
-			if ( ntmp<26 && ntmp>=0 )
-			newstr_addchar( &tmp, abc[ntmp] );
-			nsame++;
-			dup[j] = -1;
-			n = fields_find( b->ref[j], "REFNUM", -1 );
-			if ( n!=-1 )
-				newstr_strcpy( &((b->ref[j])->data[n]), tmp.data);
+	/* one pass, suffixing each key by its rank within its group */
+	for ( j=0; j<citekeys->n; ++j ) {
+		if ( dup[j]==-1 ) continue;
+		nsame = count[ dup[j] ]++;
+		newstr_strcpy( &tmp, citekeys->str[j].data );
+		ntmp = nsame;
+		while ( ntmp >= 26 ) {
+			newstr_addchar( &tmp, 'a' );
+			ntmp -= 26;
 		}
+		if ( ntmp<26 && ntmp>=0 )
+			newstr_addchar( &tmp, abc[ntmp] );
+		dup[j] = -1;
+		n = fields_find( b->ref[j], "REFNUM", -1 );
+		if ( n!=-1 )
+			newstr_strcpy( &((b->ref[j])->data[n]), tmp.data);
 	}
 	newstr_free( &tmp );
+	free( count );
 }
 
 static void
@@ -385,22 +387,39 @@ get_citekeys( bibl *b, lists *citekeys )
 static int 
 dup_citekeys( bibl *b, lists *citekeys )
 {
-	int i, j, *dup, ndup=0;
-	dup = ( int * ) malloc( sizeof( int ) * citekeys->n );
-	if ( !dup ) return 0;
-	for ( i=0; i<citekeys->n; ++i ) dup[i] = -1;
-	for ( i=0; i<citekeys->n-1; ++i ) {
-		if ( dup[i]!=-1 ) continue;
-		for ( j=i+1; j<citekeys->n; ++j ) {
+	int i, j, h, *dup, *hash, *next, nhash = 64, ndup=0;
+	while ( nhash < citekeys->n ) nhash *= 2;
+	dup  = ( int * ) malloc( sizeof( int ) * citekeys->n );
+	next = ( int * ) malloc( sizeof( int ) * citekeys->n );
+	hash = ( int * ) malloc( sizeof( int ) * nhash );
+	if ( !dup || !next || !hash ) {
+		if ( dup ) free( dup );
+		if ( next ) free( next );
+		if ( hash ) free( hash );
+		return 0;
+	}
+	for ( i=0; i<nhash; ++i ) hash[i] = -1;
+	/* mark each repeat with the index of the key's first use */
+	for ( j=0; j<citekeys->n; ++j ) {
+		dup[j] = -1;
+		h = strhash( citekeys->str[j].data ) & ( nhash-1 );
+		for ( i=hash[h]; i!=-1; i=next[i] ) {
 			if ( !strcmp( citekeys->str[i].data, 
-				citekeys->str[j].data ) ) {
-					dup[i] = i;
-					dup[j] = i;
-					ndup++;
-			}
+				citekeys->str[j].data ) ) break;
+		}
+		if ( i!=-1 ) {
+			dup[i] = i;
+			dup[j] = i;
+			ndup++;
+		} else {
+			/* only first uses go in the table */
+			next[j] = hash[h];
+			hash[h] = j;
 		}
 	}
 	if ( ndup ) resolve_citekeys( b, citekeys, dup );
+	free( hash );
+	free( next );
 	free( dup );
 	return ndup;
 }
@@ -436,7 +455,6 @@ convert_ref( bibl *bin, char *fname, bibl *bout, convert_rules *r, param *p )
 			bibl_verbose1( rout, rin, fname, i+1 );
 		bibl_addref( bout, rout );
 	}
-	uniqueify_citekeys( bout );
 	return BIBL_OK;
 }
 
@@ -565,6 +583,7 @@ bibl_setreadparams( param *np, param *op, int mode )
 		np->format_opts = op->format_opts;
 		np->addcount = op->addcount;
 		np->output_raw = op->output_raw;
+		np->readpart = op->readpart;
 	}
 	np->utf8out = 1;
 	np->charsetout = BIBL_CHARSET_UNICODE;
@@ -592,12 +611,28 @@ bibl_read( bibl *b, FILE *fp, char *filename, int mode, param *p )
 		if ( p->verbose > 1 ) bibl_verbose0( &bin );
 		bibl_copy( b, &bin );
 	}
-	if ( !lp.output_raw || ( lp.output_raw & BIBL_RAW_WITHMAKEREFID ) )
-		bibl_checkrefid( b, &lp );
+	if ( !lp.readpart ) bibl_finishread( b, &lp );
 	bibl_free( &bin );
 	return BIBL_OK;
 }
 
+/* bibl_finishread()
+ *
+ *   Make citekeys unique and give every reference one.  Both depend on
+ *   the whole input, so when it is read in pieces with p->readpart set
+ *   this is left to be called once on the pieces put back in order.
+ */
+int
+bibl_finishread( bibl *b, param *p )
+{
+	if ( !b || !p ) return BIBL_ERR_BADINPUT;
+	if ( !p->output_raw )
+		uniqueify_citekeys( b );
+	if ( !p->output_raw || ( p->output_raw & BIBL_RAW_WITHMAKEREFID ) )
+		bibl_checkrefid( b, p );
+	return BIBL_OK;
+}
+
 static FILE *
 singlerefname( fields *reffields, long nref, int mode )
 {
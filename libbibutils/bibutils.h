@@ -69,11 +69,13 @@ typedef struct param {
 	int verbose;
 	int addcount;  /* add reference count to reference id */
 	int singlerefperfile;
+	int readpart;  /* input is one piece of several, see bibl_finishread() */
 
 } param;
 
 extern void bibl_initparams( param *p, int readmode, int writemode );
 extern int bibl_read( bibl *b, FILE *fp, char *filename, int mode, param *p );
+extern int bibl_finishread( bibl *b, param *p );
 extern int bibl_write( bibl *b, FILE *fp, int mode, param *p );
 extern void bibl_reporterr( int err );
 
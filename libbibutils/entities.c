@@ -7,7 +7,9 @@
  */
 #include <stdio.h>
 #include <string.h>
+#include <strings.h>
 #include <ctype.h>
+#include <pthread.h>
 #include "entities.h"
 
 /* HTML 4.0 entities */
@@ -281,24 +283,82 @@ entities html_entities[] = {
 };
 
 
+/* entity_hash
+ *
+ *   html_entities[] hashed on the case-folded name, built on first
+ *   use.  Matching is case-insensitive and the first entry in the
+ *   list wins, as it did when the list was searched in order.
+ */
+#define ENTITY_HASH_SIZE 1024
+
+static int entity_hash[ENTITY_HASH_SIZE];
+static pthread_once_t entity_hash_once = PTHREAD_ONCE_INIT;
+
+/* FNV-1a of the case-folded bytes */
 static unsigned int
-decode_html_entity( char *s, unsigned int *pi, int *err )
+entity_hash_key( const char *s, int len )
+{
+	unsigned int h = 2166136261U;
+	int i;
+	for ( i=0; i<len; ++i ) {
+		h ^= (unsigned char) tolower( (unsigned char) s[i] );
+		h *= 16777619U;
+	}
+	return h;
+}
+
+static void
+entity_hash_build( void )
 {
 	int nhtml_entities = sizeof( html_entities ) / sizeof( entities );
+	unsigned int h;
 	char *e;
-	int i, n=-1, len;
-	for ( i=0; i<nhtml_entities && n==-1; ++i ) {
+	int i, len, slot;
+	for ( i=0; i<ENTITY_HASH_SIZE; ++i ) entity_hash[i] = -1;
+	for ( i=0; i<nhtml_entities; ++i ) {
 		e = &(html_entities[i].html[0]);
 		len = strlen( e );
-		if ( !strncasecmp( &(s[*pi]), e, len ) ) {
-			n = i;
-			*pi += len;
+		h = entity_hash_key( e, len );
+		slot = h & ( ENTITY_HASH_SIZE-1 );
+		while ( entity_hash[slot]!=-1 ) {
+			if ( !strcasecmp( html_entities[entity_hash[slot]].html, e ) )
+				break;
+			slot = ( slot+1 ) & ( ENTITY_HASH_SIZE-1 );
 		}
+		if ( entity_hash[slot]==-1 ) entity_hash[slot] = i;
 	}
+}
+
+static unsigned int
+decode_html_entity( char *s, unsigned int *pi, int *err )
+{
+	char *p = &(s[*pi]);
+	int n=-1, len, slot;
+
+	pthread_once( &entity_hash_once, entity_hash_build );
+
+	/* Every entity is "&name;", so only the text up to the first
+	 * semicolon can match, and then only one name */
+	for ( len=1; len<(int) sizeof( html_entities[0].html ); ++len )
+		if ( !p[len] || p[len]==';' ) break;
+	if ( p[len]==';' ) {
+		len++;
+		slot = entity_hash_key( p, len ) & ( ENTITY_HASH_SIZE-1 );
+		while ( entity_hash[slot]!=-1 ) {
+			if ( strlen( html_entities[entity_hash[slot]].html )==len &&
+			     !strncasecmp( p, html_entities[entity_hash[slot]].html, len ) ) {
+				n = entity_hash[slot];
+				break;
+			}
+			slot = ( slot+1 ) & ( ENTITY_HASH_SIZE-1 );
+		}
+	}
+
 	if ( n==-1 ) {
 		*err = 1;
 		return '&';
 	} else {
+		*pi += len;
 		*err = 0;
 		return html_entities[n].unicode;
 	}
@@ -10,73 +10,116 @@
 #include <stdlib.h>
 #include <string.h>
 #include "strsearch.h"
+#include "strhash.h"
 #include "fields.h"
 
+/* fields_chunk
+ *
+ * tag and data strings are carved out of a few large chunks rather
+ * than malloc'ed one by one; they all go in fields_free()
+ */
+struct fields_chunk {
+	struct fields_chunk *next;
+	unsigned long size, used;
+	char buf[1];
+};
+
+static unsigned int
+fields_hash( char *tag )
+{
+	return strcasehash( tag ) & ( FIELDS_HASHSIZE - 1 );
+}
+
+static char *
+fields_store( fields *info, char *s, unsigned long len )
+{
+	struct fields_chunk *c = info->chunks;
+	unsigned long size;
+	char *p;
+	if ( !c || c->used + len + 1 > c->size ) {
+		size = ( c ) ? c->size * 2 : 1024;
+		if ( size > 65536 ) size = 65536;
+		if ( size < len + 1 ) size = len + 1;
+		c = (struct fields_chunk *) malloc( sizeof( *c ) + size );
+		if ( !c ) return NULL;
+		c->size = size;
+		c->used = 0;
+		c->next = info->chunks;
+		info->chunks = c;
+	}
+	p = &( c->buf[c->used] );
+	memcpy( p, s, len + 1 );
+	c->used += len + 1;
+	return p;
+}
+
+/* fields_grow()
+ *
+ * the five per-field arrays share one block
+ */
+static int
+fields_grow( fields *info )
+{
+	newstr *newtags, *newdata;
+	int *newused, *newlevel, *newnext;
+	int min_alloc = 20, i, n = info->nfields;
+	if ( info->maxfields ) min_alloc = info->maxfields * 2;
+	newtags = (newstr *) malloc( ( sizeof(newstr) * 2 + sizeof(int) * 3 )
+			* min_alloc );
+	if ( !newtags ) return 0;
+	newdata  = newtags + min_alloc;
+	newused  = (int *) ( newdata + min_alloc );
+	newlevel = newused + min_alloc;
+	newnext  = newlevel + min_alloc;
+	if ( n ) {
+		memcpy( newtags, info->tag, sizeof(newstr) * n );
+		memcpy( newdata, info->data, sizeof(newstr) * n );
+		memcpy( newused, info->used, sizeof(int) * n );
+		memcpy( newlevel, info->level, sizeof(int) * n );
+		memcpy( newnext, info->next, sizeof(int) * n );
+	}
+	for ( i=n; i<min_alloc; ++i ) {
+		newstr_initmovable( &(newtags[i]) );
+		newstr_initmovable( &(newdata[i]) );
+	}
+	if ( info->tag ) free( info->tag );
+	info->tag   = newtags;
+	info->data  = newdata;
+	info->used  = newused;
+	info->level = newlevel;
+	info->next  = newnext;
+	info->maxfields = min_alloc;
+	return 1;
+}
+
 int
 fields_add( fields *info, char *tag, char *data, int level )
 {
-	newstr *newtags, *newdata;
-	int *newused, *newlevel;
-	int min_alloc = 20, i, found;
+	unsigned long taglen, datalen;
+	unsigned int h;
+	char *t, *d;
+	int i;
 	if ( !tag || !data ) return 1;
-	if ( info->maxfields==0 ){
-		info->tag = (newstr*)malloc( sizeof(newstr) * min_alloc );
-		info->data= (newstr*)malloc( sizeof(newstr) * min_alloc );
-		info->used= (int*)      malloc( sizeof(int) * min_alloc );
-		info->level=(int*)      malloc( sizeof(int) * min_alloc );
-		if ( !info->tag || !info->data || !info->used || !info->level ){
-			if ( info->tag ) free( info->tag );
-			if ( info->data ) free( info->data );
-			if ( info->used ) free( info->used );
-			if ( info->level ) free( info->level );
-			return 0;
-		}
-		info->maxfields = min_alloc;
-		info->nfields = 0;
-		for ( i=0; i<min_alloc; ++i ) {
-			newstr_init(&(info->tag[i]));
-			newstr_init(&(info->data[i]));
-		}
-	} else if ( info->nfields >= info->maxfields ){
-		min_alloc = info->maxfields * 2;
-		newtags = (newstr*) realloc( info->tag,
-			       	sizeof(newstr) * min_alloc );
-		newdata = (newstr*) realloc( info->data,
-				sizeof(newstr) * min_alloc );
-		newused = (int*)    realloc( info->used,
-				sizeof(int) * min_alloc );
-		newlevel= (int*)    realloc( info->level,
-				sizeof(int) * min_alloc );
-		if ( !newtags || !newdata || !newused || !newlevel ) {
-			if ( newtags ) info->tag=newtags;
-			if ( newdata ) info->data=newdata;
-			if ( newused ) info->used=newused;
-			if ( newlevel ) info->level=newlevel;
-			return 0;
-		}
-		info->tag = newtags;
-		info->data = newdata;
-		info->used = newused;
-		info->level = newlevel;
-		info->maxfields = min_alloc;
-		for ( i=info->nfields; i<min_alloc; ++i ) {
-			newstr_init(&(info->tag[i]));
-			newstr_init(&(info->data[i]));
-		}
-	}
-	found = 0;
-	for ( i=0; i<info->nfields && !found; ++i ) {
+	if ( info->nfields >= info->maxfields && !fields_grow( info ) )
+		return 0;
+	h = fields_hash( tag );
+	for ( i=info->hash[h]; i!=-1; i=info->next[i] ) {
 		if ( info->level[i]==level &&
 		     !strcasecmp( info->tag[i].data, tag ) &&
-		     !strcasecmp( info->data[i].data, data ) ) found=1;
-	}
-	if ( !found ) {
-		newstr_strcpy( &(info->tag[info->nfields]), tag );
-		newstr_strcpy( &(info->data[info->nfields]), data );
-		info->used[ info->nfields ] = 0;
-		info->level[ info->nfields ] = level;
-		info->nfields++;
+		     !strcasecmp( info->data[i].data, data ) ) return 1;
 	}
+	taglen = strlen( tag );
+	datalen = strlen( data );
+	t = fields_store( info, tag, taglen );
+	d = fields_store( info, data, datalen );
+	if ( !t || !d ) return 0;
+	i = info->nfields++;
+	newstr_borrow( &(info->tag[i]), t, taglen+1 );
+	newstr_borrow( &(info->data[i]), d, datalen+1 );
+	info->used[i] = 0;
+	info->level[i] = level;
+	info->next[i] = info->hash[h];
+	info->hash[h] = i;
 	return 1;
 }
 
@@ -108,44 +151,55 @@ fields_new( void )
 void
 fields_init( fields *info )
 {
+	int i;
 	info->used  = NULL;
 	info->level = NULL;
 	info->tag   = NULL;
 	info->data  = NULL;
+	info->next  = NULL;
+	info->chunks = NULL;
 	info->maxfields = info->nfields = 0;
+	for ( i=0; i<FIELDS_HASHSIZE; ++i )
+		info->hash[i] = -1;
 }
 
 void
 fields_free( fields *info )
 {
+	struct fields_chunk *c, *next;
 	int i;
 	for (i=0; i<info->maxfields; ++i) {
 		newstr_free( &(info->tag[i]) );
 		newstr_free( &(info->data[i]) );
 	}
-	if ( info->tag )  free( info->tag );
-	if ( info->data ) free( info->data );
-	if ( info->used ) free( info->used );
-	if ( info->level ) free( info->level );
+	if ( info->tag ) free( info->tag );
+	for ( c=info->chunks; c; c=next ) {
+		next = c->next;
+		free( c );
+	}
 	fields_init( info );
 }
 
 int
 fields_find( fields *info, char *searchtag, int level )
 {
-	int i, found = -1;
-	for ( i=0; i<info->nfields && found==-1; ++i ) {
+	int i, h, found = -1;
+	/* buckets are chained newest first; the oldest match wins */
+	h = fields_hash( searchtag );
+	for ( i=info->hash[h]; i!=-1; i=info->next[i] ) {
 		if ( (level==-1 || level==info->level[i]) &&
-//		     strsearch( info->tag[i].data, searchtag )==info->tag[i].data ) {
-		     !strcasecmp( info->tag[i].data, searchtag ) ) {
+		     info->data[i].len!=0 &&
+		     !strcasecmp( info->tag[i].data, searchtag ) )
 			found = i;
-			/* if there is no data for the tag, mark as unfound */
-			/* but set "used" so noise is suppressed */
-			if ( info->data[i].len==0 ) {
-				found=-1;
-				info->used[i] = 1;
-			}
-		}
+	}
+	/* matches with no data before it are skipped as unfound */
+	/* but set "used" so noise is suppressed */
+	for ( i=info->hash[h]; i!=-1; i=info->next[i] ) {
+		if ( found!=-1 && i>=found ) continue;
+		if ( (level==-1 || level==info->level[i]) &&
+		     info->data[i].len==0 &&
+		     !strcasecmp( info->tag[i].data, searchtag ) )
+			info->used[i] = 1;
 	}
 	return found;
 }
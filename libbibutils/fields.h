@@ -15,13 +15,21 @@
 
 #include "newstr.h"
 
+/* tags are indexed by hash when added, so they must not be
+ * edited in place afterwards; data may be
+ */
+#define FIELDS_HASHSIZE (64)
+
 typedef struct {
 	newstr    *tag;
 	newstr    *data;
 	int       *used;
 	int       *level;
+	int       *next;	/* previous field in the same hash bucket */
 	int       nfields;
 	int       maxfields;
+	int       hash[FIELDS_HASHSIZE];	/* latest field per bucket */
+	struct fields_chunk *chunks;	/* storage for tag/data strings */
 } fields;
 
 extern int  fields_add( fields *info, char *tag, char *data, int level );
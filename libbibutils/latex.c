@@ -9,7 +9,9 @@
  *
  */
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include "latex.h"
 
 struct latex_chars {
@@ -314,6 +316,81 @@ static struct latex_chars latex_chars[] = {
 
 static int nlatex_chars = sizeof(latex_chars)/sizeof(struct latex_chars);
 
+/* latex_trie
+ *
+ *   All the LaTeX spellings in latex_chars[] as a prefix tree, built
+ *   on first use, so that latex2char() walks the input once instead of
+ *   trying every spelling in turn.  Most characters are plain text
+ *   and are turned away by the root's direct lookup.
+ *
+ *   Each node that ends a spelling records which one, as
+ *   entry*3+variant: where strncmp() order would first have found it.
+ */
+struct latex_trie_node {
+	int child;      /* first child, or -1 */
+	int sibling;    /* next sibling, or -1 */
+	int match;      /* entry*3+variant ending here, or -1 */
+	char c;
+};
+
+static struct latex_trie_node *latex_trie = NULL;
+static int latex_trie_root[256];
+static pthread_once_t latex_trie_once = PTHREAD_ONCE_INIT;
+
+static void
+latex_trie_build( void )
+{
+	int i, j, n, max, node, next, len, k;
+	char *q;
+
+	max = 0;
+	for ( i=0; i<nlatex_chars; ++i ) {
+		max += strlen( latex_chars[i].bib1 );
+		max += strlen( latex_chars[i].bib2 );
+		max += strlen( latex_chars[i].bib3 );
+	}
+	latex_trie = ( struct latex_trie_node * )
+		malloc( sizeof( struct latex_trie_node ) * ( max + 1 ) );
+	if ( !latex_trie ) return;
+
+	for ( i=0; i<256; ++i ) latex_trie_root[i] = -1;
+	n = 0;
+
+	for ( i=0; i<nlatex_chars; ++i ) {
+		for ( j=0; j<3; ++j ) {
+			q = ( j==0 ) ? latex_chars[i].bib1 :
+			    ( j==1 ) ? latex_chars[i].bib2 : latex_chars[i].bib3;
+			len = strlen( q );
+			if ( !len ) continue;
+
+			node = -1;
+			for ( k=0; k<len; ++k ) {
+				if ( node==-1 ) next = latex_trie_root[(unsigned char) q[k]];
+				else next = latex_trie[node].child;
+				while ( next!=-1 && latex_trie[next].c!=q[k] )
+					next = latex_trie[next].sibling;
+				if ( next==-1 ) {
+					next = n++;
+					latex_trie[next].c = q[k];
+					latex_trie[next].child = -1;
+					latex_trie[next].match = -1;
+					if ( node==-1 ) {
+						latex_trie[next].sibling = -1;
+						latex_trie_root[(unsigned char) q[k]] = next;
+					} else {
+						latex_trie[next].sibling = latex_trie[node].child;
+						latex_trie[node].child = next;
+					}
+				}
+				node = next;
+			}
+			/* Earlier entries win, as with the linear search */
+			if ( latex_trie[node].match==-1 )
+				latex_trie[node].match = i*3 + j;
+		}
+	}
+}
+
 /* latex2char()
  *
  *   Use the latex_chars[] lookup table to determine if any character
@@ -323,30 +400,42 @@ static int nlatex_chars = sizeof(latex_chars)/sizeof(struct latex_chars);
  *   meaning that the output is whatever character set was given to us
  *   (which could be Unicode, but is not necessarily Unicode).
  *
+ *   Of the spellings that prefix the input, the one earliest in the
+ *   table is used, whatever its length.
  */
 unsigned int
 latex2char( char *s, unsigned int *pos, int *unicode )
 {
 	unsigned int value;
-	char *p, *q[3];
-	int i, j, l[3];
+	char *p;
+	int node, best = -1, bestlen = 0, len;
 	p = &( s[*pos] );
 	value = (unsigned char) *p;
-	for ( i=0; i<nlatex_chars; ++i ) {
-		q[0] = latex_chars[i].bib1;
-		l[0] = strlen( q[0] );
-		q[1] = latex_chars[i].bib2;
-		l[1] = strlen( q[1] );
-		q[2] = latex_chars[i].bib3;
-		l[2] = strlen( q[2] );
-		for ( j=0; j<3; ++j ) {
-			if ( l[j] && !strncmp( p, q[j], l[j] ) ) {
-				*pos = *pos + l[j];
-				*unicode = 1;
-				return latex_chars[i].unicode;
+
+	pthread_once( &latex_trie_once, latex_trie_build );
+
+	if ( latex_trie && *p ) {
+		node = latex_trie_root[(unsigned char) *p];
+		len = 1;
+		while ( node!=-1 ) {
+			if ( latex_trie[node].match!=-1 &&
+			     ( best==-1 || latex_trie[node].match<best ) ) {
+				best = latex_trie[node].match;
+				bestlen = len;
 			}
+			if ( !p[len] ) break;
+			node = latex_trie[node].child;
+			while ( node!=-1 && latex_trie[node].c!=p[len] )
+				node = latex_trie[node].sibling;
+			len++;
 		}
 	}
+
+	if ( best!=-1 ) {
+		*pos = *pos + bestlen;
+		*unicode = 1;
+		return latex_chars[best/3].unicode;
+	}
 	*unicode = 0;
 	*pos = *pos + 1;
 	return value;
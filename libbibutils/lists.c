@@ -19,7 +19,7 @@ lists_alloc( lists *a )
 	a->max = min_alloc;
 	a->n = 0;
 	for ( i=0; i<min_alloc; ++i )
-		newstr_init( &(a->str[i]) );
+		newstr_initmovable( &(a->str[i]) );
 	return 1;
 }
 
@@ -33,7 +33,7 @@ lists_realloc( lists *a )
 	a->max = min_alloc;
 	a->str = nd;
 	for ( i=a->n; i<a->max; ++i )
-		newstr_init( &(a->str[i]) );
+		newstr_initmovable( &(a->str[i]) );
 	return 1;
 }
 
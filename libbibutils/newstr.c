@@ -30,6 +30,20 @@ newstr_init( newstr *s )
 	s->dim=0;
 	s->len=0;
 	s->data=NULL;
+	s->borrowed=0;
+	s->movable=0;
+}
+
+/* newstr_initmovable()
+ *
+ * for strings kept in arrays that get realloc'ed: data never points
+ * into the string itself, so moving it around stays safe
+ */
+void
+newstr_initmovable( newstr *s )
+{
+	newstr_init( s );
+	s->movable=1;
 }
 
 static void 
@@ -37,6 +51,14 @@ newstr_initalloc( newstr *s, unsigned long minsize )
 {
 	unsigned long size = newstr_initlen;
 	assert( s );
+	s->borrowed=0;
+	if ( minsize <= NEWSTR_SMALL && !s->movable ) {
+		s->data = s->small;
+		s->data[0]='\0';
+		s->dim=NEWSTR_SMALL;
+		s->len=0;
+		return;
+	}
 	if ( minsize > newstr_initlen ) size = minsize;
 	s->data = (char *) malloc (sizeof( *(s->data) ) * size);
 	if ( !s->data ) {
@@ -53,8 +75,10 @@ newstr_new( void )
 {
 	newstr *s;
 	s = (newstr *) malloc( sizeof( *s ) );
-	if ( s ) 
-		newstr_initalloc( s, newstr_initlen );
+	if ( s ) {
+		newstr_init( s );
+		newstr_initalloc( s, 1 );
+	}
 	return s;
 }
 
@@ -72,6 +96,12 @@ newstr_empty( newstr *s )
 	}
 }
 
+/* heap storage is ours to free or realloc; small[] and borrowed
+ * blocks aren't
+ */
+#define newstr_ownsdata( s ) \
+	( (s)->data && (s)->data!=(s)->small && !(s)->borrowed )
+
 #ifndef NEWSTR_PARANOIA
 
 void 
@@ -80,10 +110,12 @@ newstr_free( newstr *s )
 	assert( s );
 	s->dim=0;
 	s->len=0;
-	if ( s->data ) free( s->data );
+	if ( newstr_ownsdata( s ) ) free( s->data );
 	s->data=NULL;
+	s->borrowed=0;
 }
 
+/* grows geometrically, so appends are amortized O(1) */
 static void 
 newstr_realloc( newstr *s, unsigned long minsize )
 {
@@ -92,13 +124,20 @@ newstr_realloc( newstr *s, unsigned long minsize )
 	assert( s );
 	size = 2 * s->dim;
 	if (size < minsize) size = minsize;
-	newptr = (char *) realloc( s->data, sizeof( *(s->data) )*size );
+	if (size < newstr_initlen) size = newstr_initlen;
+	if ( !newstr_ownsdata( s ) ) {
+		/* copy out of small[] or the lender's block */
+		newptr = (char *) malloc( sizeof( *(s->data) )*size );
+		if ( newptr ) memcpy( newptr, s->data, s->dim );
+	} else
+		newptr = (char *) realloc( s->data, sizeof( *(s->data) )*size );
 	if (newptr==NULL) {
 		fprintf(stderr,"Error.  Cannot reallocate memory (%ld bytes) in newstr_realloc.\n", sizeof(*(s->data))*size);
 		exit(1);
 	}
 	s->data = newptr;
 	s->dim = size;
+	s->borrowed = 0;
 }
 
 #else
@@ -111,8 +150,9 @@ newstr_free( newstr *s )
 	for ( i=0; i<s->dim; ++i )
 		s->data[i]='\0';
 	s->dim = 0;
-	if ( s->data ) free( s->data );
+	if ( newstr_ownsdata( s ) ) free( s->data );
 	s->data = NULL;
+	s->borrowed = 0;
 }
 
 void 
@@ -124,17 +164,21 @@ newstr_realloc(newstr *s, unsigned long minsize)
 	size = 2 * s->dim;
 	if ( size < minsize )
 		size = minsize;
+	if ( size < newstr_initlen )
+		size = newstr_initlen;
 	newptr = (char *) malloc( sizeof( *(s->data) ) * size );
 	if ( !newptr ) {
 		fprintf( stderr, "Error.  Cannot reallocate memory (%d bytes)"
 			" in newstr_realloc.\n", sizeof(*(s->data))*size );
 		exit(1);
 	}
+	if ( s->data ) memcpy( newptr, s->data, s->dim );
 	for ( i=0; i<s->dim; ++i )
 		s->data[i]='\0';
-	if ( s->data ) free( s->data );
+	if ( newstr_ownsdata( s ) ) free( s->data );
 	s->data = newptr;
 	s->dim = size;
+	s->borrowed = 0;
 }
 
 #endif
@@ -144,7 +188,7 @@ newstr_addchar( newstr *s, char newchar )
 {
 	assert( s );
 	if ( !s->data || s->dim==0 ) 
-		newstr_initalloc( s, newstr_initlen );
+		newstr_initalloc( s, 2 );
 	if ( s->len + 2 > s->dim ) 
 		newstr_realloc( s, s->len+2 );
 	s->data[s->len++] = newchar;
@@ -193,38 +237,46 @@ newstr_strcat( newstr *s, char *addstr )
 	s->data[s->len]='\0';
 }
 
+/* newstr_memcat( s, p, n )
+ *
+ * appends n characters from p in one go; readers use this instead
+ * of newstr_addchar() for runs of ordinary text
+ */
+void
+newstr_memcat( newstr *s, char *p, unsigned long n )
+{
+	assert( s && p );
+	if ( !s->data || !s->dim )
+		newstr_initalloc( s, n+1 );
+	else if ( s->len + n + 1 > s->dim )
+		newstr_realloc( s, s->len + n + 1 );
+	memmove( &(s->data[s->len]), p, n );
+	s->len += n;
+	s->data[s->len]='\0';
+}
+
 void
 newstr_segcat( newstr *s, char *startat, char *endat )
 {
 	size_t seglength;
-	char *p, *q;
+	char *nul;
 
 	assert( s && startat && endat );
 	assert( (size_t) startat < (size_t) endat );
 
 	seglength=(size_t) endat - (size_t) startat;
-	if ( !s->data || !s->dim )
-		newstr_initalloc( s, seglength+1 );
-	else {
-		if ( s->len + seglength + 1 > s->dim )
-			newstr_realloc(s, s->len + seglength+1);
-	}
-	q = &(s->data[s->len]);
-	p = startat;
-	while ( *p && p!=endat ) *q++ = *p++;
-	*q = '\0';
-	s->len += seglength;
+	/* stop short at an embedded terminator, as always */
+	nul = (char *) memchr( startat, '\0', seglength );
+	if ( nul ) seglength = (size_t) nul - (size_t) startat;
+	newstr_memcat( s, startat, seglength );
 }
 
 void
 newstr_newstrcpy( newstr *s, newstr *old )
 {
 	assert( s && old );
-	if ( !old->data || !old->dim ) {
-		s->dim = 0;
-		if ( s->data ) s->data[0]='\0';
-		/* modify for NEWSTR_PARANOIA */
-	} else newstr_strcpy( s, old->data );
+	if ( !old->data || !old->dim ) newstr_empty( s );
+	else newstr_strcpy( s, old->data );
 }
 
 void 
@@ -250,24 +302,17 @@ void
 newstr_segcpy( newstr *s, char *startat, char *endat )
 {
 	size_t seglength;
-	char *p, *q;
+	char *nul;
 
 	assert( s && startat && endat );
 	assert( ((size_t) startat) <= ((size_t) endat) );
 
 	seglength=(size_t) endat - (size_t) startat;
 	if ( seglength==0 ) return;
-	if (s->data==NULL || s->dim==0)
-		newstr_initalloc( s, seglength+1 );
-	else {
-		if ( seglength+1 > s->dim )
-			newstr_realloc( s, seglength+1 );
-	}
-	q = s->data;
-	p = startat;
-	while ( *p && p!=endat ) *q++ = *p++;
-	*q = '\0';
-	s->len = seglength;
+	nul = (char *) memchr( startat, '\0', seglength );
+	if ( nul ) seglength = (size_t) nul - (size_t) startat;
+	s->len = 0;
+	newstr_memcat( s, startat, seglength );
 }
 
 void
@@ -350,12 +395,15 @@ newstr_findreplace( newstr *s, char *find, char *replace )
 int
 newstr_fget( FILE *fp, char *buf, int bufsize, int *pbufpos, newstr *outs )
 {
-	int  bufpos = *pbufpos, done = 0;
+	int  bufpos = *pbufpos, done = 0, start;
 	char *ok;
 	newstr_empty( outs );
 	while ( !done ) {
+		start = bufpos;
 		while ( buf[bufpos] && buf[bufpos]!='\r' && buf[bufpos]!='\n' )
-			newstr_addchar( outs, buf[bufpos++] );
+			bufpos++;
+		if ( bufpos > start )
+			newstr_memcat( outs, &(buf[start]), bufpos - start );
 		if ( buf[bufpos]=='\0' ) {
 			ok = fgets( buf, bufsize, fp );
 			bufpos=*pbufpos=0;
@@ -382,6 +430,20 @@ newstr_toupper( newstr *s )
 		s->data[i] = toupper( s->data[i] );
 }
 
+/* move a small string to the heap */
+static void
+newstr_unsmall( newstr *s )
+{
+	char *p = (char *) malloc( sizeof( *(s->data) ) * newstr_initlen );
+	if ( !p ) {
+		fprintf(stderr,"Error.  Cannot allocate memory in newstr_unsmall.\n");
+		exit(1);
+	}
+	memcpy( p, s->small, NEWSTR_SMALL );
+	s->data = p;
+	s->dim = newstr_initlen;
+}
+
 /* newstr_swapstrings( s1, s2 )
  * be sneaky and swap internal newstring data from one
  * string to another
@@ -389,7 +451,7 @@ newstr_toupper( newstr *s )
 void
 newstr_swapstrings( newstr *s1, newstr *s2 )
 {
-	char *tmpp;
+	char *tmpp, small[NEWSTR_SMALL];
 	int tmp;
 
 	assert( s1 && s2 );
@@ -408,6 +470,36 @@ newstr_swapstrings( newstr *s1, newstr *s2 )
 	tmpp = s1->data;
 	s1->data = s2->data;
 	s2->data = tmpp;
+
+	tmp = s1->borrowed;
+	s1->borrowed = s2->borrowed;
+	s2->borrowed = tmp;
+
+	/* small strings travel by value */
+	memcpy( small, s1->small, NEWSTR_SMALL );
+	memcpy( s1->small, s2->small, NEWSTR_SMALL );
+	memcpy( s2->small, small, NEWSTR_SMALL );
+	if ( s1->data==s2->small ) s1->data = s1->small;
+	if ( s2->data==s1->small ) s2->data = s2->small;
+	if ( s1->movable && s1->data==s1->small ) newstr_unsmall( s1 );
+	if ( s2->movable && s2->data==s2->small ) newstr_unsmall( s2 );
+}
+
+/* newstr_borrow( s, buf, dim )
+ *
+ * point s at a string in a buffer of dim bytes owned by someone
+ * else; s copies it out before it ever needs to grow and never
+ * frees it
+ */
+void
+newstr_borrow( newstr *s, char *buf, unsigned long dim )
+{
+	assert( s && buf && dim );
+	newstr_free( s );
+	s->data = buf;
+	s->dim = dim;
+	s->len = strlen( buf );
+	s->borrowed = 1;
 }
 
 void
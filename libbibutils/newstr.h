@@ -12,18 +12,27 @@
 
 #include <stdio.h>
 
+/* short strings live in small[] instead of on the heap, unless the
+ * newstr itself may move (an element of a growable array) */
+#define NEWSTR_SMALL (16)
+
 typedef struct newstr {
 	char *data;
 	unsigned long dim;
 	unsigned long len;
+	int borrowed;	/* data lives in someone else's block (see fields) */
+	int movable;	/* never point data at small */
+	char small[NEWSTR_SMALL];
 }  newstr;
 
 newstr *newstr_new   ( void ); 
 void newstr_init        ( newstr *string );
+void newstr_initmovable ( newstr *string );
 void newstr_free        ( newstr *string );
 void newstr_addchar     ( newstr *string, char newchar );
 void newstr_strcat      ( newstr *string, char *addstr );
 void newstr_segcat      ( newstr *string, char *startat, char *endat );
+void newstr_memcat      ( newstr *string, char *p, unsigned long n );
 void newstr_prepend     ( newstr *string, char *addstr );
 void newstr_strcpy      ( newstr *string, char *addstr );
 void newstr_newstrcpy   ( newstr *s, newstr *old );
@@ -37,6 +46,7 @@ void newstr_empty       ( newstr *string );
 void newstr_toupper     ( newstr *s );
 void newstr_trimendingws( newstr *s );
 void newstr_swapstrings ( newstr *s1, newstr *s2 );
+void newstr_borrow      ( newstr *s, char *buf, unsigned long dim );
 
 /* NEWSTR_PARANOIA
  *
@@ -14,6 +14,8 @@
 #include <string.h>
 #include <ctype.h>
 #include <limits.h>
+#include <strings.h>
+#include <pthread.h>
 #include "newstr.h"
 #include "is_ws.h"
 #include "latex.h"
@@ -23,15 +25,63 @@
 
 #include "charsets.h"
 
+/* FNV-1a of the case-folded name */
+static unsigned int
+charset_hash_key( const char *s )
+{
+	unsigned int h = 2166136261U;
+	for ( ; *s; ++s ) {
+		h ^= (unsigned char) tolower( (unsigned char) *s );
+		h *= 16777619U;
+	}
+	return h;
+}
+
+/* Charset names and alternative names to index in allcharconvert[],
+ * the first listed winning as with a search in order */
+#define CHARSET_HASH_SIZE 512
+
+static int charset_hash[CHARSET_HASH_SIZE];
+static pthread_once_t charset_hash_once = PTHREAD_ONCE_INIT;
+
+static void
+charset_hash_add( char *name, int n )
+{
+	int slot, i;
+	slot = charset_hash_key( name ) & ( CHARSET_HASH_SIZE-1 );
+	while ( ( i = charset_hash[slot] )!=-1 ) {
+		if ( !strcasecmp( name, allcharconvert[i].name ) ||
+		     !strcasecmp( name, allcharconvert[i].name2 ) )
+			return;
+		slot = ( slot+1 ) & ( CHARSET_HASH_SIZE-1 );
+	}
+	charset_hash[slot] = n;
+}
+
+static void
+charset_hash_build( void )
+{
+	int i;
+	for ( i=0; i<CHARSET_HASH_SIZE; ++i ) charset_hash[i] = -1;
+	for ( i=0; i<nallcharconvert; ++i ) {
+		charset_hash_add( allcharconvert[i].name, i );
+		if ( allcharconvert[i].name2[0]!='\0' )
+			charset_hash_add( allcharconvert[i].name2, i );
+	}
+}
+
 int
 get_charset( char *name )
 {
-	int i;
+	int slot, i;
 	if ( name==NULL ) return CHARSET_UNKNOWN;
-	for ( i=0; i<nallcharconvert; ++i ){
+	pthread_once( &charset_hash_once, charset_hash_build );
+	slot = charset_hash_key( name ) & ( CHARSET_HASH_SIZE-1 );
+	while ( ( i = charset_hash[slot] )!=-1 ) {
 		if ( !strcasecmp( name, allcharconvert[i].name ) ) return i;
 		else if ( allcharconvert[i].name2[0]!='\0' &&
 			!strcasecmp( name, allcharconvert[i].name2 ) ) return i;
+		slot = ( slot+1 ) & ( CHARSET_HASH_SIZE-1 );
 	}
 	return CHARSET_UNKNOWN;
 }
@@ -101,17 +151,90 @@ addxmlchar( newstr *s, unsigned int ch )
 static unsigned int
 lookupchar( int charsetin, char c )
 {
-	return allcharconvert[charsetin].table[(int)c];
+	return allcharconvert[charsetin].table[(unsigned char)c];
 }
 
+/* Reverse charset tables, unicode to byte, all made together the
+ * first time any charset is written, so that lookups afterwards are
+ * read-only and need no lock.  Open addressing over twice as many
+ * slots as a charset has characters; the lowest byte wins where a
+ * charset maps two to the same character, as it did with a linear
+ * search.
+ */
+#define REVERSE_SIZE 512
+
+typedef struct reverse_slot {
+	unsigned int unicode;
+	int c;           /* -1 for an empty slot */
+} reverse_slot;
+
+static reverse_slot **reverse_tables = NULL;
+static pthread_once_t reverse_tables_once = PTHREAD_ONCE_INIT;
+
 static unsigned int
-lookupuni( int charsetout, unsigned int unicode )
+reverse_hash( unsigned int unicode )
+{
+	return ( unicode * 2654435761U ) >> 23;
+}
+
+static reverse_slot *
+reverse_build( int charset )
+{
+	reverse_slot *table;
+	unsigned int u;
+	int i, slot;
+	table = ( reverse_slot * ) malloc( sizeof( reverse_slot ) * REVERSE_SIZE );
+	if ( !table ) return NULL;
+	for ( i=0; i<REVERSE_SIZE; ++i ) table[i].c = -1;
+	for ( i=0; i<allcharconvert[charset].ntable && i<256; ++i ) {
+		u = allcharconvert[charset].table[i];
+		slot = reverse_hash( u ) & ( REVERSE_SIZE-1 );
+		while ( table[slot].c!=-1 && table[slot].unicode!=u )
+			slot = ( slot+1 ) & ( REVERSE_SIZE-1 );
+		if ( table[slot].c==-1 ) {
+			table[slot].unicode = u;
+			table[slot].c = i;
+		}
+	}
+	return table;
+}
+
+/* A charset whose table couldn't be made is left NULL and falls
+ * back to the linear search.
+ */
+static void
+reverse_tables_build( void )
 {
 	int i;
+	reverse_tables = ( reverse_slot ** )
+		calloc( nallcharconvert, sizeof( reverse_slot * ) );
+	if ( !reverse_tables ) return;
+	for ( i=0; i<nallcharconvert; ++i )
+		reverse_tables[i] = reverse_build( i );
+}
+
+static unsigned int
+lookupuni( int charsetout, unsigned int unicode )
+{
+	reverse_slot *table;
+	int i, slot;
 	if ( charsetout==CHARSET_UNICODE ) return unicode;
-	for ( i=0; i<256; ++i ) {
-		if ( unicode == allcharconvert[charsetout].table[i] )
-			return i;
+
+	pthread_once( &reverse_tables_once, reverse_tables_build );
+	table = reverse_tables ? reverse_tables[charsetout] : NULL;
+
+	if ( !table ) {
+		for ( i=0; i<256; ++i ) {
+			if ( unicode == allcharconvert[charsetout].table[i] )
+				return i;
+		}
+		return '?';
+	}
+
+	slot = reverse_hash( unicode ) & ( REVERSE_SIZE-1 );
+	while ( table[slot].c!=-1 ) {
+		if ( table[slot].unicode==unicode ) return table[slot].c;
+		slot = ( slot+1 ) & ( REVERSE_SIZE-1 );
 	}
 	return '?';
 }
@@ -181,15 +304,20 @@ newstr_convert( newstr *s,
 	unsigned int ch;
 	newstr ns;
 	unsigned int pos = 0;
+	char buf[512] = "";
 	if ( s->len==0 ) return;
+	/* most values fit the scratch buffer and can be copied back */
+	/* into s's own storage without touching the heap */
 	newstr_init( &ns );
+	newstr_borrow( &ns, buf, sizeof( buf ) );
 	if ( charsetin==CHARSET_UNKNOWN ) charsetin = CHARSET_DEFAULT;
 	if ( charsetout==CHARSET_UNKNOWN ) charsetout = CHARSET_DEFAULT;
 	while ( s->data[pos] ) {
 		ch = get_unicode( s, &pos, charsetin, latexin, utf8in, xmlin );
 		write_unicode( &ns, ch, charsetout, latexout, utf8out, xmlout );
 	}
-	newstr_swapstrings( s, &ns );
+	if ( ns.borrowed ) newstr_strcpy( s, ns.data );
+	else newstr_swapstrings( s, &ns );
 	newstr_free( &ns );
 }
 
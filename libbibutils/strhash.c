@@ -0,0 +1,35 @@
+/*
+ * strhash.c
+ *
+ * Source code released under the GPL
+ *
+ */
+#include <ctype.h>
+#include "strhash.h"
+
+/* strhash(), FNV-1a hash of a string
+ *
+ * mask off the low bits for a power-of-two table
+ */
+unsigned int
+strhash( char *s )
+{
+	unsigned int h = 2166136261U;
+	while ( *s ) {
+		h ^= (unsigned int) (unsigned char) *s++;
+		h *= 16777619U;
+	}
+	return h;
+}
+
+/* strcasehash(), same, but agrees with strcasecmp() */
+unsigned int
+strcasehash( char *s )
+{
+	unsigned int h = 2166136261U;
+	while ( *s ) {
+		h ^= (unsigned int) tolower( (unsigned char) *s++ );
+		h *= 16777619U;
+	}
+	return h;
+}
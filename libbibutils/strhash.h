@@ -0,0 +1,14 @@
+/*
+ * strhash.h
+ *
+ * Source code released under the GPL
+ *
+ */
+#ifndef STRHASH_H
+#define STRHASH_H
+
+extern unsigned int strhash( char *s );
+extern unsigned int strcasehash( char *s );
+
+#endif
+
@@ -0,0 +1,62 @@
+
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef AUTHORLIST_H
+#define AUTHORLIST_H
+
+#include <string>
+#include <vector>
+
+#include <glibmm.h>
+
+/*
+ * One name from a BibTeX author field, split the way BibTeX splits
+ * "First von Last", "von Last, First" and "von Last, Jr, First".
+ * Braces are stripped from the parts.
+ */
+class Author {
+	public:
+	Glib::ustring given_;
+	Glib::ustring particle_;
+	Glib::ustring family_;
+	Glib::ustring suffix_;
+	/* The name as written, without braces */
+	Glib::ustring display_;
+};
+
+/*
+ * A parsed "A and B and C" author field.  Parsing happens once, when
+ * BibData's authors are set, so that captions, key generation and
+ * sorting never need to scan the raw string again.
+ */
+class AuthorList {
+	public:
+	typedef std::vector<Author>::const_iterator const_iterator;
+
+	void parse (Glib::ustring const &raw);
+	void clear ();
+
+	const_iterator begin () const {return authors_.begin ();}
+	const_iterator end () const {return authors_.end ();}
+	bool empty () const {return authors_.empty ();}
+	int size () const {return authors_.size ();}
+	Author const &first () const {return authors_.front ();}
+
+	/* Collation key on the first author's family then given names */
+	std::string const &getSortKey () const {return sortKey_;}
+
+	private:
+	std::vector<Author> authors_;
+	std::string sortKey_;
+};
+
+#endif
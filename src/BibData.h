@@ -20,17 +20,24 @@
 #include <gtkmm.h>
 #include <libxml/xmlwriter.h>
 
-#include "CaseFoldCompare.h"
+#include "AuthorList.h"
+#include "FieldName.h"
+#include "StringPool.h"
+
+class IdentifierScanner;
 
 class BibData {
 	private:
-	Glib::ustring type_;
+	/* Low-cardinality values are shared through StringPool */
+	SharedString type_;
 	Glib::ustring doi_;
 	Glib::ustring volume_;
 	Glib::ustring issue_;
 	Glib::ustring pages_;
 	Glib::ustring authors_;
-	Glib::ustring journal_;
+	/* authors_ parsed into names, kept in step by setAuthors */
+	AuthorList authorList_;
+	SharedString journal_;
 	Glib::ustring title_;
 	Glib::ustring year_;
 
@@ -42,37 +49,113 @@ class BibData {
 
 	static Glib::ustring &getDefaultDocType ();
 
-	void writeXML (xmlTextWriterPtr writer);
+	void writeXML (xmlTextWriterPtr writer) const;
 	void print () const;
 	void clear ();
 
 	void mergeIn (BibData const &source);
+	void fillIn (BibData const &source);
+
+	/*
+	 * Extra fields keyed by interned field name.  Documents rarely
+	 * carry more than a dozen extras, so a linear scan over a flat
+	 * vector of integer ids beats a tree of case-folding compares.
+	 * Entries are kept in the order of a map sorted by casefoldCompare,
+	 * and keep the spelling their name was first given in this document.
+	 */
+	class ExtrasMap {
+		public:
+		class Key {
+			public:
+			/* Spelt as name */
+			explicit Key (Glib::ustring const &name)
+				: node_ (FieldName::internNode (name)) {}
+
+			FieldName::Id id () const {return node_->id_;}
+			Glib::ustring const &str () const {return node_->text_;}
+			bool operator< (Key const &other) const
+				{return FieldName::less (node_, other.node_);}
+
+			private:
+			FieldName::Node const *node_;
+		};
+
+		typedef std::pair<Key, SharedString> value_type;
+		typedef std::vector<value_type> Container;
+		typedef Container::iterator iterator;
+		typedef Container::const_iterator const_iterator;
+
+		iterator begin () {return entries_.begin ();}
+		iterator end () {return entries_.end ();}
+		const_iterator begin () const {return entries_.begin ();}
+		const_iterator end () const {return entries_.end ();}
+		bool empty () const {return entries_.empty ();}
+		Container::size_type size () const {return entries_.size ();}
+		void clear () {entries_.clear ();}
+		void erase (iterator it) {entries_.erase (it);}
+
+		iterator find (FieldName::Id id)
+		{
+			iterator it = entries_.begin ();
+			for (; it != entries_.end () && it->first.id () != id; ++it);
+			return it;
+		}
+		const_iterator find (FieldName::Id id) const
+		{
+			const_iterator it = entries_.begin ();
+			for (; it != entries_.end () && it->first.id () != id; ++it);
+			return it;
+		}
+		iterator find (Glib::ustring const &key)
+			{return find (FieldName::lookup (key));}
+		const_iterator find (Glib::ustring const &key) const
+			{return find (FieldName::lookup (key));}
+
+		/* Value of a field, empty if it is not set */
+		Glib::ustring const &get (FieldName::Id id) const
+		{
+			const_iterator it = find (id);
+			return it == entries_.end () ? empty_.str () : it->second.str ();
+		}
+		Glib::ustring const &get (Glib::ustring const &key) const
+			{return get (FieldName::lookup (key));}
+
+		/* An existing field keeps its spelling, as a map key would */
+		void set (Key const &key, Glib::ustring const &value);
+		void set (Key const &key, SharedString const &value);
+		void set (Glib::ustring const &key, Glib::ustring const &value)
+			{set (Key (key), value);}
+
+		private:
+		Container entries_;
+		static SharedString const empty_;
+	};
 
-	typedef std::map <Glib::ustring, Glib::ustring, casefoldCompare> ExtrasMap;
 	ExtrasMap extras_;
 	void addExtra (Glib::ustring const &key, Glib::ustring const &value);
 	void clearExtras ();
-	ExtrasMap getExtras () const {return extras_;}
+	ExtrasMap const &getExtras () const {return extras_;}
 	bool hasExtras () {return !extras_.empty();}
 
 	void setDoi (Glib::ustring const &doi) {doi_ = doi;}
-	Glib::ustring getDoi () const {return doi_;}
-	void setType (Glib::ustring const &type) {type_ = type;}
-	Glib::ustring getType () const {return type_;} 
+	Glib::ustring const &getDoi () const {return doi_;}
+	void setType (Glib::ustring const &type) {type_ = StringPool::instance().intern (type);}
+	Glib::ustring const &getType () const {return type_.str ();}
 	void setTitle (Glib::ustring const &title) {title_ = title;}
-	Glib::ustring getTitle () const {return title_;}
+	Glib::ustring const &getTitle () const {return title_;}
 	void setVolume (Glib::ustring const &vol) {volume_ = vol;}
-	Glib::ustring getVolume () const {return volume_;}
+	Glib::ustring const &getVolume () const {return volume_;}
 	void setIssue (Glib::ustring const &issue) {issue_ = issue;}
-	Glib::ustring getIssue () const {return issue_;}
+	Glib::ustring const &getIssue () const {return issue_;}
 	void setPages (Glib::ustring const &pages) {pages_ = pages;}
-	Glib::ustring getPages () const {return pages_;}
-	void setAuthors (Glib::ustring const &authors) {authors_ = authors;}
-	Glib::ustring getAuthors () const {return authors_;}
-	void setJournal (Glib::ustring const &journal) {journal_ = journal;}
-	Glib::ustring getJournal () const {return journal_;}
+	Glib::ustring const &getPages () const {return pages_;}
+	void setAuthors (Glib::ustring const &authors) {authors_ = authors; authorList_.parse (authors);}
+	Glib::ustring const &getAuthors () const {return authors_;}
+	AuthorList const &getAuthorList () const {return authorList_;}
+	void setJournal (Glib::ustring const &journal) {journal_ = StringPool::instance().intern (journal);}
+	Glib::ustring const &getJournal () const {return journal_.str ();}
 	void setYear (Glib::ustring const &year) {year_ = year;}
-	Glib::ustring getYear () const {return year_;}
+	Glib::ustring const &getYear () const {return year_;}
 
 	void guessJournal (Glib::ustring const &raw);
 	void guessVolumeNumberPage (Glib::ustring const &raw);
@@ -80,7 +163,12 @@ class BibData {
 	void guessAuthors (Glib::ustring const &raw);
 	void guessTitle (Glib::ustring const &raw);
 	void guessDoi (Glib::ustring const &raw);
-	void guessArxiv (Glib::ustring const &raw_);
+	void guessArxiv (Glib::ustring const &raw);
+	/* Year, DOI, eprint, PMID and ISBN together */
+	void guessIdentifiers (Glib::ustring const &raw);
+
+	private:
+	void applyIdentifiers (IdentifierScanner const &scanner);
 };
 
 #endif
@@ -34,7 +34,11 @@ int getType (fields *info);
 
 std::string formatPeople(fields *info, char *tag, char *ctag, int level);
 std::string formatPerson (std::string const &munged);
+/* A BibTeX author or editor field, formatted as formatPeople would */
+std::string formatNames (std::string const &names);
 
+/* What parseBibUtils puts in a Document, without making one */
+void bibDataFromBibUtils (BibUtils::fields *ref, Glib::ustring &citekey, BibData &bib);
 Document parseBibUtils (BibUtils::fields *ref);
 
 Format guessFormat (std::string const &rawtext);
@@ -45,6 +49,14 @@ void biblFromString (
 	Format format,
 	param &p);
 
+/* C linkage: this can't be another overload of biblFromString */
+void biblFromBuffer (
+	bibl &b,
+	char const *text,
+	size_t length,
+	Format format,
+	param &p);
+
 }
 }
 
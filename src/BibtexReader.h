@@ -0,0 +1,98 @@
+
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef BIBTEXREADER_H
+#define BIBTEXREADER_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Document.h"
+
+/*
+ * Reads BibTeX straight into Documents.  The input is scanned in
+ * place: only field values that are kept are ever copied, with @string
+ * macros expanded, LaTeX special characters decoded to UTF-8 and
+ * crossref'd fields inherited from their parent entry.
+ *
+ * Large inputs are split between entries and the pieces parsed on
+ * one thread per processor.  Each piece sees exactly the macros that
+ * a front-to-back read would, and crossrefs are resolved across the
+ * whole input once every piece is done.
+ */
+class BibtexReader {
+	public:
+	BibtexReader ();
+
+	/* Appends one Document per entry to docs, returns how many */
+	int parse (char const *text, size_t length, std::vector<Document> &docs);
+	int parse (std::string const &text, std::vector<Document> &docs)
+		{return parse (text.data (), text.size (), docs);}
+	/* The same without making Documents: a key and BibData per entry */
+	int parse (
+		char const *text,
+		size_t length,
+		std::vector<Glib::ustring> &keys,
+		std::vector<BibData> &bibs);
+
+	private:
+	typedef std::map<std::string, std::string> Macros;
+
+	class Entry {
+		public:
+		std::string type_;
+		std::string key_;
+		/* Lower-cased field names, values with macros expanded */
+		typedef std::vector<std::pair<std::string, std::string> > Fields;
+		Fields fields_;
+
+		std::string const *find (std::string const &name) const;
+	};
+
+	/* A stretch of input that one thread handles */
+	class Chunk {
+		public:
+		char const *begin_;
+		char const *end_;
+		/* Where each @string's body starts, and what closes it */
+		std::vector<std::pair<char const *, char> > strings_;
+		/* Macros defined before begin_ */
+		Macros macros_;
+		std::vector<Entry> entries_;
+		std::vector<BibData> bibs_;
+	};
+
+	char const *pos_;
+	char const *end_;
+	Macros macros_;
+
+	void skipSpace ();
+	bool atEnd () const {return pos_ >= end_;}
+	std::string readName ();
+	bool readValue (char close, std::string &value);
+	bool readDelimited (char open, std::string &value);
+	void skipBlock (char close);
+	bool readEntry (char close, Entry &entry);
+	void readMacros (char close);
+	bool nextEntry (std::string &type, char &close);
+
+	int read (char const *text, size_t length, std::vector<Chunk> &chunks);
+	static void split (char const *text, size_t length, std::vector<Chunk> &chunks);
+	static void findStrings (Chunk *chunk);
+	static void readChunk (Chunk *chunk);
+	static void convertChunk (Chunk *chunk);
+	static void inherit (Entry &entry, Entry const &parent);
+	static void makeBibData (Entry const &entry, BibData &bib);
+};
+
+#endif
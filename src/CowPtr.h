@@ -0,0 +1,73 @@
+
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef COWPTR_H
+#define COWPTR_H
+
+#include <glib.h>
+
+/*
+ * Copy-on-write holder: copies share one T until somebody calls
+ * write(), which makes a private copy if the value is shared.  The
+ * reference count is atomic, so a copy can be handed to another
+ * thread and read there while the original is being edited.
+ */
+template <class T>
+class CowPtr {
+	public:
+	CowPtr () : node_ (new Node (T ())) {}
+	explicit CowPtr (T const &value) : node_ (new Node (value)) {}
+	CowPtr (CowPtr const &x) : node_ (x.node_) {g_atomic_int_inc (&node_->refs);}
+	~CowPtr () {release ();}
+
+	CowPtr &operator= (CowPtr const &x)
+	{
+		Node *node = x.node_;
+		g_atomic_int_inc (&node->refs);
+		release ();
+		node_ = node;
+		return *this;
+	}
+
+	T const &operator* () const {return node_->value;}
+	T const *operator-> () const {return &node_->value;}
+
+	T &write ()
+	{
+		if (g_atomic_int_get (&node_->refs) != 1) {
+			Node *copy = new Node (node_->value);
+			release ();
+			node_ = copy;
+		}
+		return node_->value;
+	}
+
+	bool shares (CowPtr const &x) const {return node_ == x.node_;}
+
+	private:
+	class Node {
+		public:
+		Node (T const &v) : refs (1), value (v) {}
+		volatile gint refs;
+		T value;
+	};
+
+	void release ()
+	{
+		if (g_atomic_int_dec_and_test (&node_->refs))
+			delete node_;
+	}
+
+	Node *node_;
+};
+
+#endif
@@ -17,25 +17,55 @@
 #include <libxml/xmlwriter.h>
 
 #include "BibData.h"
+#include "CowPtr.h"
 
+class DocumentList;
 class DocumentView;
 class Library;
 
 class Document {
+	public:
+	/* Kinds of change reported to the DocumentList, as mask bits */
+	enum Change {
+		CHANGE_FIELDS = 1 << 0,
+		CHANGE_KEY = 1 << 1,
+		CHANGE_TAGS = 1 << 2,
+		CHANGE_FILE = 1 << 3,
+		CHANGE_ADDED = 1 << 4,
+		CHANGE_REMOVED = 1 << 5
+	};
+
 	private:
 	Glib::ustring filename_;
 	Glib::ustring relfilename_;
-	Glib::ustring key_;
-	Glib::ustring notes_;
-	std::vector<int> tagUids_;
 	Glib::RefPtr<Gdk::Pixbuf> thumbnail_;
 	static const Glib::ustring defaultKey_;
 	static Glib::RefPtr<Gdk::Pixbuf> loadingthumb_;
 
 	void setupThumbnail ();
 	DocumentView *view_;
-
-	BibData bib_;
+	/* The list we belong to, if any, told about filename changes */
+	DocumentList *list_;
+	/* Our row in the list's DocumentTable, -1 if none */
+	int tableRow_;
+
+	/*
+	 * The editable state of a document.  It is shared with copies and
+	 * snapshots of the document until one of them writes to it, so
+	 * taking a snapshot does not copy any metadata.
+	 */
+	class Record {
+		public:
+		Glib::ustring key_;
+		Glib::ustring notes_;
+		std::vector<int> tagUids_;
+		BibData bib_;
+	};
+	CowPtr<Record> record_;
+	Record &edit (unsigned int const change);
+	void changed (unsigned int const change);
+	/* Incremented on every change to the document */
+	unsigned long generation_;
 
 	public:
 	~Document ();
@@ -78,7 +108,7 @@ class Document {
 	Glib::ustring const & getNotes() const;
 	void setNotes(Glib::ustring const &notes);
 
-	std::vector<int>& getTags ();
+	std::vector<int> const &getTags () const {return record_->tagUids_;}
 	void setTag (int uid);
 	void clearTag (int uid);
 	void clearTags ();
@@ -86,8 +116,12 @@ class Document {
 	Glib::RefPtr<Gdk::Pixbuf> getThumbnail () {return thumbnail_;}
 	void setThumbnail (Glib::RefPtr<Gdk::Pixbuf> thumb);
 	void setView (DocumentView *view) {view_ = view;}
+	void setList (DocumentList *list) {list_ = list;}
+	unsigned long getGeneration () const {return generation_;}
+	int getTableRow () const {return tableRow_;}
+	void setTableRow (int row) {tableRow_ = row;}
 
-	bool hasTag (int uid);
+	bool hasTag (int uid) const;
 	bool canGetMetadata ();
 	bool matchesSearch (Glib::ustring const &search);
 
@@ -110,11 +144,19 @@ class Document {
          */
         void readXML(xmlNodePtr docNode);
 	bool readPDF ();
+	static bool readPDF (Glib::ustring const &uri, BibData &bib, bool &gotText);
 	bool getMetaData ();
 	void renameFromKey ();
 
-	BibData& getBibData () {return bib_;}
-	void setBibData (BibData& bib){bib_ = bib;}
+	BibData const &getBibData () const {return record_->bib_;}
+	/* Marks the fields changed: only for callers that modify them */
+	BibData &editBibData ();
+	void setBibData (BibData& bib);
+
+	/* Key, notes, tags and metadata as they are now */
+	typedef CowPtr<Record> Snapshot;
+	Snapshot getSnapshot () const {return record_;}
+	void restore (Snapshot const &snapshot);
 
 	Glib::ustring generateKey ();
 
@@ -122,9 +164,21 @@ class Document {
 
 	typedef std::map <Glib::ustring, Glib::ustring> FieldMap;
 
+	/*
+	 * Receives each metadata field by reference, without the
+	 * document's fields being copied anywhere
+	 */
+	class FieldVisitor {
+		public:
+		virtual ~FieldVisitor () {}
+		/* Return false to stop visiting */
+		virtual bool visit (Glib::ustring const &field, Glib::ustring const &value) = 0;
+	};
+
 	void setField (Glib::ustring const &field, Glib::ustring const &value);
 	Glib::ustring getField (Glib::ustring const &field);
 	bool hasField (Glib::ustring const &field) const;
+	bool visitFields (FieldVisitor &visitor) const;
 	FieldMap getFields ();
 	void clearFields ();
 
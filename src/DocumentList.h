@@ -15,12 +15,16 @@
 
 #include <gtkmm.h>
 #include <sstream>
+#include <deque>
 #include <list>
+#include <map>
 #include <libxml/xmlwriter.h>
 
 #include "BibUtils.h"
 
 #include "Document.h"
+#include "DocumentTable.h"
+#include "IdentityIndex.h"
 
 
 
@@ -31,10 +35,129 @@ class DocumentList {
 	private:
 	Container docs_;
 
+	/* Where each document is in docs_, so removal needn't search */
+	typedef std::map <Document*, Container::iterator> Positions;
+	Positions positions_;
+
+	/* Normalised file URI -> documents, used to reject duplicate files */
+	typedef std::multimap <Glib::ustring, Document*> FileNameIndex;
+	FileNameIndex filenameIndex_;
+
+	/* Sort and filter attributes of docs_, by column */
+	DocumentTable table_;
+
+	/* DOI, eprint, PMID and title fingerprint -> document */
+	IdentityIndex identities_;
+
 	public:
+	/*
+	 * The state of some documents before a bulk operation.  Document
+	 * snapshots share their records until the document is edited, so
+	 * a checkpoint costs a pointer per document rather than a copy.
+	 */
+	class Checkpoint {
+		public:
+		class Entry {
+			public:
+			Entry (Document *doc)
+				: doc_ (doc), before_ (doc->getSnapshot ()), after_ (before_) {}
+			Document *doc_;
+			Document::Snapshot before_;
+			/* As the operation left it: if the document no longer
+			 * shares this, it has been edited since */
+			Document::Snapshot after_;
+		};
+		typedef std::vector<Entry> Entries;
+		Glib::ustring description_;
+		Entries docs_;
+		/* Tags deleted by the operation, uid to name */
+		std::map<int, std::string> tags_;
+	};
+
+	/*
+	 * Documents changed since listeners were last told, each with a
+	 * mask of Document::Change bits.  Removed documents no longer
+	 * exist: only their addresses may be used.
+	 */
+	class ChangeSet {
+		public:
+		ChangeSet () : mask_ (0) {}
+		typedef std::map<Document*, unsigned int> Docs;
+		Docs docs_;
+		/* Every kind of change in the set */
+		unsigned int mask_;
+	};
+	typedef sigc::signal<void, ChangeSet const &> ChangedSignal;
+
+	/*
+	 * Holds back notifications until the outermost Batch ends, so that
+	 * a bulk operation is reported once
+	 */
+	class Batch {
+		public:
+		Batch (DocumentList &list) : list_ (list) {list_.beginBatch ();}
+		~Batch () {list_.endBatch ();}
+		private:
+		DocumentList &list_;
+	};
+
+	/* What import does with records the library already has */
+	enum DuplicatePolicy {
+		DUPLICATES_IMPORT,
+		DUPLICATES_SKIP,
+		/* Fill the existing document's empty fields from the imported record */
+		DUPLICATES_MERGE
+	};
+
+	class ImportReport {
+		public:
+		ImportReport () : skipped_ (0), merged_ (0) {}
+		/* The documents created, in import order */
+		std::vector<Document*> added_;
+		int skipped_;
+		int merged_;
+		/* One line for each record that matched an existing one */
+		std::vector<Glib::ustring> lines_;
+	};
+
+	private:
+	/* Library-wide generation, incremented on any change */
+	unsigned long generation_;
+	ChangeSet pending_;
+	ChangedSignal changed_;
+	int batchDepth_;
+	sigc::connection idle_;
+	bool onIdle ();
+
+	std::deque<Checkpoint> undo_;
+	static unsigned int const maxUndo_ = 16;
+
+	Document *appendDoc (Document const &doc);
+	void indexFileName (Document *doc);
+	void unindexFileName (Document *doc, Glib::ustring const &filename);
+	void forgetUndo (Document *doc);
+
+	public:
+	DocumentList () : generation_ (0), batchDepth_ (0) {}
+	~DocumentList () {idle_.disconnect ();}
+
 	Container& getDocs ();
 	int size () {return docs_.size();}
 	Document* newDocWithFile (Glib::ustring const &filename);
+	Document* findDocWithFile (Glib::ustring const &filename);
+	void fileNameChanged (Document *doc, Glib::ustring const &oldfilename);
+	static Glib::ustring normalizeFileName (Glib::ustring const &filename);
+	DocumentTable& getTable () {return table_;}
+	void tagsChanged (Document *doc) {table_.updateTags (doc);}
+
+	unsigned long getGeneration () const {return generation_;}
+	/* Called by Document, and by us for additions and removals */
+	void documentChanged (Document *doc, unsigned int const change);
+	ChangedSignal &signalChanged () {return changed_;}
+	void beginBatch () {++batchDepth_;}
+	void endBatch ();
+	/* Tell listeners about pending changes now rather than when idle */
+	void flushChanges ();
 	Document* newDocWithName (Glib::ustring const &key);
 	Document* newDocUnnamed ();
 	Document* insertDoc (Document const &doc);
@@ -61,10 +184,32 @@ class DocumentList {
 	void print ();
 	void clearTag (int uid);
 	void writeXML (xmlTextWriterPtr writer);
-	void clear () {docs_.clear ();}
+	void clear ();
 
-	int importFromFile (Glib::ustring const &filename, BibUtils::Format format);
-	int import (Glib::ustring const &rawtext, BibUtils::Format format);
+	Checkpoint &checkpoint (
+		Glib::ustring const &description,
+		std::vector<Document*> const &docs);
+	bool canUndo () const {return !undo_.empty ();}
+	Glib::ustring const &getUndoDescription () const {return undo_.back ().description_;}
+	bool endCheckpoint ();
+	Checkpoint undo (std::vector<Document*> &skipped);
+
+	int importFromFile (
+		Glib::ustring const &filename,
+		BibUtils::Format format,
+		DuplicatePolicy policy = DUPLICATES_IMPORT,
+		ImportReport *report = NULL);
+	int import (
+		Glib::ustring const &rawtext,
+		BibUtils::Format format,
+		DuplicatePolicy policy = DUPLICATES_IMPORT,
+		ImportReport *report = NULL);
+	int import (
+		char const *text,
+		size_t length,
+		BibUtils::Format format,
+		DuplicatePolicy policy = DUPLICATES_IMPORT,
+		ImportReport *report = NULL);
 	Document parseBibUtils (BibUtils::fields *ref);
 };
 
@@ -0,0 +1,69 @@
+
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef DOCUMENTTABLE_H
+#define DOCUMENTTABLE_H
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include <glibmm.h>
+
+class Document;
+
+/*
+ * Column-oriented shadow of the document attributes that the views
+ * sort and filter on, kept in step with DocumentList.  Each attribute
+ * lives in its own contiguous array indexed by row, and documents
+ * know their row, so comparisons and counts are tight loops over
+ * integers and precomputed collation keys instead of string parsing.
+ */
+class DocumentTable {
+	public:
+	DocumentTable () : tagWords_ (0) {}
+
+	void add (Document *doc);
+	/* Recompute a row after the document's metadata changed */
+	void update (Document *doc);
+	void updateTags (Document *doc);
+	void remove (Document *doc);
+	void clear ();
+	int size () const {return docs_.size ();}
+
+	/* Sort comparisons, negative if a sorts before b */
+	int compareYears (Document const *a, Document const *b) const;
+	int compareAuthors (Document const *a, Document const *b) const;
+	int compareTitles (Document const *a, Document const *b) const;
+
+	bool hasTag (Document const *doc, int uid) const;
+	/* Number of documents carrying each tag uid */
+	void countTags (std::map<int, int> &counts) const;
+
+	private:
+	void load (int row);
+	void loadTags (int row);
+	void widenTags (int words);
+
+	std::vector<Document*> docs_;
+	/* Parsed year, 0 when missing or unparseable */
+	std::vector<int> years_;
+	/* Collation keys of the first author's surname and of the
+	 * title with any leading article removed */
+	std::vector<std::string> authorKeys_;
+	std::vector<std::string> titleKeys_;
+	/* tagWords_ 32-bit words of tag uid bits per row */
+	std::vector<guint32> tagBits_;
+	int tagWords_;
+};
+
+#endif
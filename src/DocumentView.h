@@ -13,6 +13,8 @@
 #include <gtk/gtkversion.h>
 #include <gtkmm.h>
 
+#include "DocumentList.h"
+
 class Document;
 class Library;
 class Linker;
@@ -30,6 +32,7 @@ class DocumentView : public Gtk::VBox
 	void updateDoc (Document * const doc);
 	void removeDoc (Document * const doc);
 	void addDoc (Document * doc);
+	void addDocs (std::vector<Document*> const &docs);
 	void updateVisible ();
 	void clear ();
 
@@ -82,6 +85,8 @@ class DocumentView : public Gtk::VBox
 
 	private:
 	bool ignoreSelectionChanged_;
+
+	void onDocsChanged (DocumentList::ChangeSet const &changes);
 	
 	/* The search box */
 	Gtk::Entry *searchentry_;
@@ -194,4 +199,8 @@ class DocumentView : public Gtk::VBox
 
 	int sortTitles(const Gtk::TreeModel::iterator& a,
 		       const Gtk::TreeModel::iterator& b);
+	int sortAuthors(const Gtk::TreeModel::iterator& a,
+		       const Gtk::TreeModel::iterator& b);
+	int sortYears(const Gtk::TreeModel::iterator& a,
+		       const Gtk::TreeModel::iterator& b);
 };
@@ -0,0 +1,38 @@
+
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef ENCODING_H
+#define ENCODING_H
+
+#include <string>
+
+/*
+ * Character set handling for text that arrives from outside: imported
+ * files, downloads and PDF text.  ASCII, which is nearly all of it, is
+ * skipped sixteen bytes at a time.
+ */
+namespace Encoding {
+	/* Whether the bytes are well-formed UTF-8.  NULs are allowed. */
+	bool isUtf8 (char const *text, size_t length);
+
+	/*
+	 * Append Windows-1252 text to out as UTF-8.  This is a superset of
+	 * latin1 in all but the C1 controls, which nobody means to use.
+	 * Having no state, it can be fed a stream in pieces.
+	 */
+	void appendWindows1252 (char const *text, size_t length, std::string &out);
+
+	/* Append as-is if valid UTF-8, otherwise as Windows-1252 */
+	void appendUtf8 (char const *text, size_t length, std::string &out);
+}
+
+#endif
@@ -0,0 +1,109 @@
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef EXTRACTIONCACHE_H
+#define EXTRACTIONCACHE_H
+
+#include <map>
+#include <set>
+#include <utility>
+
+#include <glibmm.h>
+
+/*
+ * What Document::readPDF got out of each file it has read, so that a
+ * file it has seen before needn't be parsed again.  Files are known by
+ * their URI, size and modification time, and failing the URI by their
+ * inode, which follows them when they are moved.  The cache is kept in
+ * a file next to the library.  Thread-safe.
+ */
+class ExtractionCache {
+	public:
+	/* Identifies a version of a file without reading it */
+	class Stamp {
+		public:
+		Stamp () : size_ (0), mtime_ (0), device_ (0), inode_ (0) {}
+
+		guint64 size_;
+		guint64 mtime_;
+		guint64 device_;
+		guint64 inode_;
+
+		bool sameVersion (Stamp const &x) const
+			{return size_ == x.size_ && mtime_ == x.mtime_;}
+	};
+
+	class Entry {
+		public:
+		Entry () : pdf_ (false), opened_ (false), pages_ (0) {}
+
+		Stamp stamp_;
+		bool pdf_;
+		/* Poppler could open it and it has pages */
+		bool opened_;
+		int pages_;
+		/* Checksum of the first page's text, empty if it had none */
+		Glib::ustring digest_;
+		/* Found in the first page */
+		Glib::ustring year_;
+		Glib::ustring doi_;
+		Glib::ustring eprint_;
+		Glib::ustring pmid_;
+		Glib::ustring isbn_;
+		/* From the XMP packet, or the document information dictionary */
+		Glib::ustring title_;
+		Glib::ustring author_;
+		/* Only ever in the XMP packet */
+		Glib::ustring journal_;
+		Glib::ustring volume_;
+		Glib::ustring issue_;
+		Glib::ustring pageRange_;
+	};
+
+	static ExtractionCache &instance ();
+
+	/*
+	 * Look up the file at uri as it is now.  On a miss entry has only
+	 * the file's stamp filled in, ready to be passed to store.
+	 */
+	bool find (Glib::ustring const &uri, Entry &entry);
+	void store (Glib::ustring const &uri, Entry const &entry);
+
+	/*
+	 * The cache file that goes with the library at liburi.  Saving
+	 * drops the entries for files not in uris, those of the library.
+	 */
+	void load (Glib::ustring const &liburi);
+	void save (Glib::ustring const &liburi, std::set<Glib::ustring> const &uris);
+
+	/* Instrumentation: lookups, and how many skipped extraction */
+	int getRequests ();
+	int getHits ();
+
+	private:
+	ExtractionCache () : dirty_ (false), requests_ (0), hits_ (0) {}
+
+	static Glib::ustring cacheUri (Glib::ustring const &liburi);
+
+	typedef std::map<Glib::ustring, Entry> UriMap;
+	typedef std::map<std::pair<guint64, guint64>, Glib::ustring> InodeMap;
+	UriMap entries_;
+	InodeMap inodes_;
+	/* Where entries_ was last loaded from or saved to */
+	Glib::ustring file_;
+	bool dirty_;
+	int requests_;
+	int hits_;
+
+	Glib::Mutex mutex_;
+};
+
+#endif
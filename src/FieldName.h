@@ -0,0 +1,79 @@
+
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef FIELDNAME_H
+#define FIELDNAME_H
+
+#include <deque>
+#include <map>
+#include <string>
+
+#include <glibmm.h>
+
+/*
+ * Process-wide table of BibTeX field names.  Names are matched
+ * case-insensitively and each distinct name is given a small integer
+ * id the first time it is seen, so that documents store ids instead
+ * of their own copies of "abstract", "url" and friends.  Each exact
+ * spelling gets a Node too, so a document can still write a name
+ * back the way it was given: "Publisher" and "publisher" are one id
+ * but two spellings.
+ */
+class FieldName {
+	public:
+	typedef int Id;
+	static Id const invalid = -1;
+
+	/*
+	 * One spelling of a name.  Nodes are never changed or freed once
+	 * made, so they are read without taking the table's lock.
+	 */
+	class Node {
+		public:
+		Node (Id id, Glib::ustring const &text, std::string const *collateKey)
+			: id_ (id), text_ (text), collateKey_ (collateKey) {}
+		Id const id_;
+		Glib::ustring const text_;
+		/* Shared by every spelling of the name */
+		std::string const * const collateKey_;
+	};
+
+	/* Id for name, allocating one if it is new */
+	static Id intern (Glib::ustring const &name) {return internNode (name)->id_;}
+	/* The node for name as spelt, allocating an id if it is new */
+	static Node const *internNode (Glib::ustring const &name);
+	/* Id for name, or invalid if it has never been interned */
+	static Id lookup (Glib::ustring const &name);
+	/* Whether a's name sorts before b's, as casefoldCompare would have it */
+	static bool less (Node const *a, Node const *b)
+		{return *a->collateKey_ < *b->collateKey_;}
+
+	private:
+	typedef std::map<Glib::ustring, Node const *> SpellingMap;
+	typedef std::map<Glib::ustring, Node const *> NameMap;
+
+	/* Exact spellings seen so far, to skip case folding */
+	SpellingMap spellings_;
+	/* Case folded names, to the first spelling of each */
+	NameMap folded_;
+	/* Deques so that pointers handed out stay valid */
+	std::deque<Node> nodes_;
+	std::deque<std::string> collateKeys_;
+	/* Only insertion takes this for writing */
+	Glib::RWLock lock_;
+
+	FieldName () {}
+	static FieldName &instance ();
+	Node const *find (Glib::ustring const &name, Glib::ustring const &folded) const;
+};
+
+#endif
@@ -0,0 +1,78 @@
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef FILEREADERPOOL_H
+#define FILEREADERPOOL_H
+
+#include <vector>
+
+#include <glibmm.h>
+
+#include "BibData.h"
+
+/*
+ * Sniffs and extracts text from document files on a bounded pool of
+ * worker threads, while the main thread takes the results in their
+ * original order.  Workers stay at most a window of files ahead of
+ * the main thread.  Only BibData is filled in here, never a Document,
+ * so none of this touches GTK+.
+ */
+class FileReaderPool {
+	public:
+	class Result {
+		public:
+		Result () : read_ (false), gotText_ (false) {}
+
+		Glib::ustring filename_;
+		BibData bib_;
+		/* Whether bib_ has anything from the file in it */
+		bool read_;
+		bool gotText_;
+	};
+
+	FileReaderPool (
+		std::vector<Glib::ustring> const &filenames,
+		int workers,
+		unsigned int window);
+	~FileReaderPool ();
+
+	/* Wait up to timeout milliseconds for the next file's result */
+	bool take (Result &result, unsigned long timeout);
+	bool done ();
+	/* Workers stop after the files they are on */
+	void cancel ();
+
+	/* Files read so far, and the rate they were read at */
+	unsigned int count ();
+	double rate ();
+
+	private:
+	void worker ();
+	static void read (Glib::ustring const &filename, Result &result);
+
+	std::vector<Glib::ustring> const filenames_;
+	/* Finished results waiting for the main thread */
+	std::vector<Result *> results_;
+	unsigned int const window_;
+	unsigned int next_;
+	unsigned int taken_;
+	unsigned int count_;
+	bool cancelled_;
+	double lastRead_;
+
+	Glib::Mutex mutex_;
+	Glib::Cond ready_;
+	Glib::Cond space_;
+	Glib::Timer timer_;
+	std::vector<Glib::Thread *> threads_;
+};
+
+#endif
@@ -0,0 +1,60 @@
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef IDENTIFIERSCANNER_H
+#define IDENTIFIERSCANNER_H
+
+#include <string>
+
+/*
+ * Picks the year, DOI, arXiv id, PubMed id and ISBN out of a paper's
+ * extracted text in a single pass.  Years, DOIs and arXiv ids are
+ * found exactly as the regular expressions that BibData used to run
+ * one at a time did.
+ */
+class IdentifierScanner {
+	public:
+	/* What to look for, as mask bits */
+	enum Kind {
+		YEAR = 1 << 0,
+		DOI = 1 << 1,
+		ARXIV = 1 << 2,
+		PMID = 1 << 3,
+		ISBN = 1 << 4,
+		ALL = YEAR | DOI | ARXIV | PMID | ISBN
+	};
+
+	explicit IdentifierScanner (int kinds = ALL) : kinds_ (kinds) {}
+
+	void scan (std::string const &text);
+
+	/* The latest plausible year, and the first of each identifier */
+	std::string const &getYear () const {return year_;}
+	std::string const &getDoi () const {return doi_;}
+	std::string const &getArxiv () const {return arxiv_;}
+	std::string const &getPmid () const {return pmid_;}
+	std::string const &getIsbn () const {return isbn_;}
+
+	private:
+	int const kinds_;
+	std::string year_;
+	std::string doi_;
+	std::string arxiv_;
+	std::string pmid_;
+	std::string isbn_;
+
+	static bool matchDoi (std::string const &text, std::string::size_type i, std::string &doi);
+	static bool matchArxiv (std::string const &text, std::string::size_type i, std::string &arxiv);
+	static bool matchPmid (std::string const &text, std::string::size_type i, std::string &pmid);
+	static bool matchIsbn (std::string const &text, std::string::size_type i, std::string &isbn);
+};
+
+#endif
@@ -0,0 +1,67 @@
+
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef IDENTITYINDEX_H
+#define IDENTITYINDEX_H
+
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+#include <glibmm.h>
+
+class BibData;
+class Document;
+
+/*
+ * Finds documents that describe the same work as some metadata, kept
+ * in step with DocumentList.  Documents are keyed on their normalised
+ * DOI, arXiv eprint and PubMed id, which identify a work outright,
+ * and on a fingerprint of title and year, which very probably does.
+ */
+class IdentityIndex {
+	public:
+	enum Match {
+		MATCH_NONE,
+		/* Same title and year, no conflicting identifiers */
+		MATCH_PROBABLE,
+		/* A shared DOI, eprint or PMID */
+		MATCH_EXACT
+	};
+
+	void add (Document *doc);
+	void remove (Document *doc);
+	/* Fields changed: rekey the document before the next lookup */
+	void invalidate (Document *doc) {stale_.insert (doc);}
+	void clear ();
+
+	/* The strongest match for bib, and the document it matched */
+	Match find (BibData const &bib, Document *&match);
+
+	private:
+	typedef std::multimap<std::string, Document*> Index;
+	Index index_;
+	/* Each document's keys, to unindex it by */
+	std::map<Document*, std::vector<std::string> > keys_;
+	std::set<Document*> stale_;
+
+	void refresh ();
+
+	static void makeKeys (BibData const &bib, std::vector<std::string> &keys);
+	static bool conflicts (BibData const &a, BibData const &b);
+	static std::string normalizeDoi (Glib::ustring const &doi);
+	static std::string normalizeEprint (Glib::ustring const &eprint);
+	static std::string fingerprint (BibData const &bib);
+};
+
+#endif
@@ -17,8 +17,9 @@
 #include <libxml/tree.h>
 #include <libxml/xmlwriter.h>
 
+#include "DocumentList.h"
+
 class Document;
-class DocumentList;
 class TagList;
 class RefWindow;
 
@@ -259,6 +260,14 @@ class Library {
         return data->taglist_;
     }
 
+    /**
+     * Relays DocumentList::signalChanged from whichever document list
+     * is current, so listeners survive loading a new library.
+     */
+    DocumentList::ChangedSignal &signalDocsChanged() {
+        return docsChanged_;
+    }
+
     bool libraryFolderDialog();
 
 	private:
@@ -281,6 +290,8 @@ private:
     struct LibraryData *data;
 
 	RefWindow &tagwindow_;
+
+	DocumentList::ChangedSignal docsChanged_;
 };
 
 #endif
@@ -18,6 +18,7 @@
 
 #include <gtkmm.h>
 
+#include "DocumentList.h"
 #include "Plugin.h"
 
 class Gtk::TreePath;
@@ -80,6 +81,7 @@ class RefWindow {
 		void clearTagList ();
 		void populateTagList ();
 		void updateTagSizes ();
+		void onDocsChanged (DocumentList::ChangeSet const &changes);
 		/* Construct main window */
 		void constructUI ();
 		/* Construct uimanager stuff */
@@ -171,6 +173,8 @@ class RefWindow {
 		/* Helpers for addDocFiles */
 		void onAddDocFilesCancel       (Gtk::Button *button, Gtk::ProgressBar *progress);
 		bool cancelAddDocFiles_;
+		bool onAddDocFilesLookupDue    ();
+		bool lookupDue_;
 		void onAddDocFilesTag          (std::vector<Document*> &docs);
 		void configureDocumentFileChooser(Gtk::FileChooserDialog & chooser);
 
@@ -244,6 +248,8 @@ class RefWindow {
 		void onCopyCite ();
 		void onRemoveDoc ();
 		void onGetMetadataDoc ();
+		void onUndo ();
+		void updateUndo ();
 		void onDeleteDoc ();
 		void onRenameDoc ();
 		public:
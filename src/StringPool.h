@@ -0,0 +1,94 @@
+
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef STRINGPOOL_H
+#define STRINGPOOL_H
+
+#include <map>
+
+#include <glibmm.h>
+
+/*
+ * Immutable, reference counted string.  Copies share one
+ * representation, so copying a Document does not copy its strings.
+ * Strings obtained from StringPool::intern are additionally shared
+ * between every holder of an equal value.
+ */
+class SharedString {
+	public:
+	SharedString () : rep_ (NULL) {}
+	explicit SharedString (Glib::ustring const &str);
+	SharedString (SharedString const &x);
+	SharedString &operator= (SharedString const &x);
+	~SharedString ();
+
+	Glib::ustring const &str () const {return rep_ ? rep_->str : empty_;}
+	bool empty () const {return str().empty ();}
+
+	private:
+	class Rep {
+		public:
+		Rep (Glib::ustring const &s, bool p) : refs (1), pooled (p), str (s) {}
+		volatile gint refs;
+		/* Pooled reps are only freed by StringPool::purge */
+		bool const pooled;
+		Glib::ustring const str;
+	};
+
+	/* Takes over a reference that the caller already holds */
+	explicit SharedString (Rep *rep) : rep_ (rep) {}
+	void release ();
+
+	Rep *rep_;
+	static Glib::ustring const empty_;
+
+	friend class StringPool;
+};
+
+
+/*
+ * Thread-safe interning pool for low-cardinality values such as
+ * document types, journals and publishers.  The pool is split into
+ * independently locked shards so that concurrent importers rarely
+ * contend; copying and reading a SharedString takes no lock at all.
+ */
+class StringPool {
+	public:
+	static StringPool &instance ();
+
+	SharedString intern (Glib::ustring const &str);
+	/* Free pooled strings that no longer have any holders */
+	void purge ();
+
+	/* Instrumentation: interning requests, how many found an existing
+	 * string, and the string bytes that sharing avoided allocating */
+	int getRequests ();
+	int getHits ();
+	long getBytesSaved ();
+
+	private:
+	StringPool () {}
+
+	static int const nShards = 16;
+	class Shard {
+		public:
+		Shard () : requests (0), hits (0), bytesSaved (0) {}
+		Glib::Mutex mutex;
+		std::map<Glib::ustring, SharedString::Rep*> strings;
+		int requests;
+		int hits;
+		long bytesSaved;
+	};
+	Shard shards_[nShards];
+};
+
+#endif
@@ -1,30 +1,63 @@
-
 #ifndef THUMBNAILGENERATOR_H
 #define THUMBNAILGENERATOR_H
 
 #include <glibmm.h>
 #include <gdkmm.h>
+#include <giomm.h>
 #include <map>
+#include <set>
+#include <vector>
 
 
 class Document;
 
+/*
+ * Fills in documents' thumbnails in the background.  Up to
+ * maxInFlight_ files at a time are looked up with GIO and decoded on
+ * a pool of threads; only handing the results to the documents
+ * happens on the main thread.
+ */
 class ThumbnailGenerator
 {
 	std::multimap<Glib::ustring, Document *> taskList_;
-	Glib::ustring currentFile_;
-	Glib::RefPtr<Gio::File> currentUri_;
-	Glib::RefPtr<Gio::File> thumbnail_file_;
+	/* Which file each document in taskList_ is waiting on */
+	std::map<Document *, Glib::ustring> requests_;
+	/* Files being looked up or decoded */
+	std::set<Glib::ustring> inFlight_;
+	bool scheduled_;
+
+	static unsigned int const maxInFlight_ = 8;
+
+	/* Decoded thumbnails for the main thread, under doneMutex_ */
+	typedef std::pair<Glib::ustring, Glib::RefPtr<Gdk::Pixbuf> > Result;
+	std::vector<Result> done_;
+	Glib::Mutex doneMutex_;
+	Glib::Dispatcher doneSignal_;
+	/* After doneSignal_, so it is shut down before that goes */
+	Glib::ThreadPool decoders_;
+
+	/* Instrumentation: how long the queue took to drain */
+	Glib::Timer timer_;
+	unsigned int filled_;
 
 	static Glib::RefPtr<Gdk::Pixbuf> defaultthumb_;
 	static Glib::RefPtr<Gdk::Pixbuf> thumbframe_;
 
 	Glib::RefPtr<Gdk::Pixbuf> lookupThumb (Glib::ustring const &file);
 	void lookupThumb_async (Glib::ustring const &file);
-	void _onQueryInfoAsyncReady(Glib::RefPtr<Gio::AsyncResult>& result);
-	void _setDocumentThumbnail(Glib::RefPtr<Gdk::Pixbuf>& result);
-	void _taskDone();
-	void _taskAbort();
+	void _onQueryInfoAsyncReady (
+		Glib::RefPtr<Gio::AsyncResult>& result,
+		Glib::ustring const &file,
+		Glib::RefPtr<Gio::File> uri);
+	void _decode (Glib::ustring const &file, std::string const &thumbnail_path);
+	void _onDecoded ();
+	void _setDocumentThumbnail (
+		Glib::ustring const &file,
+		Glib::RefPtr<Gdk::Pixbuf> const &thumbnail);
+	void _fillDocuments (
+		Glib::ustring const &file,
+		Glib::RefPtr<Gdk::Pixbuf> const &thumbnail);
+	void _schedule ();
 
 	ThumbnailGenerator ();
 	bool run ();
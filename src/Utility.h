@@ -172,6 +172,9 @@ namespace Utility {
 	Glib::ustring mozUrlSelectionToUTF8 (
 		Gtk::SelectionData const &sel);
 
+	int countProcessors ();
+	void runInParallel (std::vector<sigc::slot<void> > const &jobs);
+
 	Glib::ustring trimWhiteSpace (Glib::ustring const &str);
 	Glib::ustring trimLeadingString (Glib::ustring const &str, Glib::ustring const &leader);
 	void debug (Glib::ustring tag, Glib::ustring msg);
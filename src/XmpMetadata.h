@@ -0,0 +1,62 @@
+/*
+ * Referencer is released under the GNU General Public License v2
+ * See the COPYING file for licensing details.
+ *
+ * Copyright 2007 John Spray
+ * (Exceptions listed in README)
+ *
+ */
+
+
+
+#ifndef XMPMETADATA_H
+#define XMPMETADATA_H
+
+#include <string>
+#include <vector>
+
+#include <libxml/tree.h>
+
+/*
+ * The bibliographic parts of a PDF's XMP packet: Dublin Core title,
+ * creators and identifiers, PRISM's DOI, journal, volume, issue,
+ * pages and date, and the DOIs that Elsevier (pdfx) and CrossMark
+ * put in.  Where a property turns up more than once the first wins.
+ */
+class XmpMetadata {
+	public:
+	/* False if xmp can't be parsed as XML */
+	bool parse (std::string const &xmp);
+
+	std::string const &getTitle () const {return title_;}
+	/* Creators in BibTeX form, joined with "and" */
+	std::string getAuthors () const;
+	std::string const &getDoi () const {return doi_;}
+	std::string const &getEprint () const {return eprint_;}
+	std::string const &getJournal () const {return journal_;}
+	std::string const &getVolume () const {return volume_;}
+	std::string const &getIssue () const {return issue_;}
+	std::string getPages () const;
+	std::string const &getYear () const {return year_;}
+
+	private:
+	std::string title_;
+	std::vector<std::string> authors_;
+	std::string doi_;
+	std::string eprint_;
+	std::string journal_;
+	std::string volume_;
+	std::string issue_;
+	std::string firstPage_;
+	std::string lastPage_;
+	std::string year_;
+
+	void readNode (xmlNodePtr node);
+	void readProperty (
+		std::string const &ns,
+		std::string const &name,
+		std::vector<std::string> const &values);
+	void readIdentifier (std::string const &value);
+};
+
+#endif
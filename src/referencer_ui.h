@@ -26,6 +26,8 @@ Glib::ustring referencer_ui =
 		"      <menuitem action='Quit'/>"
 		"    </menu>"
 		"    <menu action='EditMenu'>"
+		"      <menuitem action='Undo'/>"
+		"      <separator/>"
 		"      <menuitem action='PasteBibtex'/>"
 		"      <menuitem action='CopyCite'/>"
 		"      <separator/>"
@@ -0,0 +1,113 @@
+/*
+ * bibutils-chunks.c
+ *
+ * A RIS file read in pieces, as DocumentList::import does on several
+ * threads, must come out with the same citekeys as when read whole:
+ * repeats on either side of a cut still get their a/b suffixes, and
+ * references without a key are numbered through the whole file.
+ */
+#include <stdio.h>
+#include <string.h>
+#include "bibutils.h"
+
+char progname[] = "bibutils-chunks";
+lists asis  = { 0, 0, NULL };
+lists corps = { 0, 0, NULL };
+
+static char *first =
+	"TY  - JOUR\n"
+	"AU  - Smith, John\n"
+	"PY  - 2000\n"
+	"TI  - Before the cut\n"
+	"ER  - \n"
+	"TY  - JOUR\n"
+	"TI  - No author, first piece\n"
+	"ER  - \n"
+	"TY  - JOUR\n"
+	"AU  - Jones, Ann\n"
+	"PY  - 1999\n"
+	"TI  - Only once\n"
+	"ER  - \n";
+
+static char *second =
+	"TY  - JOUR\n"
+	"AU  - Smith, John\n"
+	"PY  - 2000\n"
+	"TI  - After the cut\n"
+	"ER  - \n"
+	"TY  - JOUR\n"
+	"TI  - No author, second piece\n"
+	"ER  - \n";
+
+static int
+read_text( bibl *b, char *text, param *p )
+{
+	FILE *fp;
+	int status;
+	fp = fmemopen( text, strlen( text ), "r" );
+	if ( !fp ) return BIBL_ERR_CANTOPEN;
+	status = bibl_read( b, fp, "test", BIBL_RISIN, p );
+	fclose( fp );
+	return status;
+}
+
+static char *
+refnum( bibl *b, int i )
+{
+	int n = fields_find( b->ref[i], "REFNUM", -1 );
+	if ( n==-1 ) return "";
+	return b->ref[i]->data[n].data;
+}
+
+int
+main( void )
+{
+	bibl whole, pieces, piece;
+	param p;
+	char all[4096];
+	int i, failed = 0;
+
+	bibl_initparams( &p, BIBL_RISIN, BIBL_MODSOUT );
+	p.charsetin = BIBL_CHARSET_UNICODE;
+	p.utf8in = 1;
+
+	strcpy( all, first );
+	strcat( all, second );
+	bibl_init( &whole );
+	read_text( &whole, all, &p );
+
+	p.readpart = 1;
+	bibl_init( &pieces );
+	bibl_init( &piece );
+	read_text( &piece, first, &p );
+	for ( i=0; i<piece.nrefs; ++i ) bibl_addref( &pieces, piece.ref[i] );
+	piece.nrefs = 0;
+	bibl_free( &piece );
+	read_text( &piece, second, &p );
+	for ( i=0; i<piece.nrefs; ++i ) bibl_addref( &pieces, piece.ref[i] );
+	piece.nrefs = 0;
+	bibl_free( &piece );
+	bibl_finishread( &pieces, &p );
+
+	if ( whole.nrefs!=5 || pieces.nrefs!=whole.nrefs ) {
+		fprintf( stderr, "%s: read %ld whole, %ld in pieces\n",
+			progname, whole.nrefs, pieces.nrefs );
+		return 1;
+	}
+	if ( strcmp( refnum( &whole, 0 ), refnum( &whole, 3 ) )==0 ) {
+		fprintf( stderr, "%s: whole read left '%s' repeated\n",
+			progname, refnum( &whole, 0 ) );
+		failed = 1;
+	}
+	for ( i=0; i<whole.nrefs; ++i ) {
+		if ( strcmp( refnum( &whole, i ), refnum( &pieces, i ) ) ) {
+			fprintf( stderr, "%s: reference %d is '%s' whole, '%s' in pieces\n",
+				progname, i, refnum( &whole, i ), refnum( &pieces, i ) );
+			failed = 1;
+		}
+	}
+
+	bibl_free( &whole );
+	bibl_free( &pieces );
+	return failed;
+}
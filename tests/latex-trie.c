@@ -0,0 +1,96 @@
+/*
+ * latex-trie.c
+ *
+ * latex2char() matches against a prefix tree built from latex_chars[].
+ * Check it against the linear search over the same table that it
+ * replaced, for every spelling in the table followed by assorted text,
+ * at every offset, and for random LaTeX-looking strings.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/* For the static table, and the trie's latex2char() itself */
+#include "latex.c"
+
+/* The old latex2char() */
+static unsigned int
+linear_latex2char( char *s, unsigned int *pos, int *unicode )
+{
+	unsigned int value;
+	char *p, *q[3];
+	int i, j, l[3];
+	p = &( s[*pos] );
+	value = (unsigned char) *p;
+	for ( i=0; i<nlatex_chars; ++i ) {
+		q[0] = latex_chars[i].bib1;
+		l[0] = strlen( q[0] );
+		q[1] = latex_chars[i].bib2;
+		l[1] = strlen( q[1] );
+		q[2] = latex_chars[i].bib3;
+		l[2] = strlen( q[2] );
+		for ( j=0; j<3; ++j ) {
+			if ( l[j] && !strncmp( p, q[j], l[j] ) ) {
+				*pos = *pos + l[j];
+				*unicode = 1;
+				return latex_chars[i].unicode;
+			}
+		}
+	}
+	*unicode = 0;
+	*pos = *pos + 1;
+	return value;
+}
+
+static int ntests = 0, nfailed = 0;
+
+static void
+check( char *s, unsigned int start )
+{
+	unsigned int pos1 = start, pos2 = start, c1, c2;
+	int uni1, uni2;
+	c1 = latex2char( s, &pos1, &uni1 );
+	c2 = linear_latex2char( s, &pos2, &uni2 );
+	ntests++;
+	if ( c1!=c2 || pos1!=pos2 || uni1!=uni2 ) {
+		if ( nfailed++ < 10 )
+			fprintf( stderr, "latex-trie: '%s' at %u gives %u/%u, was %u/%u\n",
+				s, start, c1, pos1, c2, pos2 );
+	}
+}
+
+int
+main( void )
+{
+	char *suffixes[] = { "", "a", "}", "{}", "x}", "\\", "{a}" };
+	char alphabet[] = "\\{}$^'`\"~=.aeiouAEcCnNsgtxbvdrkHlLoOIj_ ";
+	char s[256], *bib;
+	unsigned int start;
+	int i, j, k, n;
+
+	for ( i=0; i<nlatex_chars; ++i ) {
+		for ( j=0; j<3; ++j ) {
+			bib = ( j==0 ) ? latex_chars[i].bib1 :
+			      ( j==1 ) ? latex_chars[i].bib2 : latex_chars[i].bib3;
+			if ( !bib[0] ) continue;
+			for ( k=0; k<(int)( sizeof( suffixes ) / sizeof( suffixes[0] ) ); ++k ) {
+				snprintf( s, sizeof( s ), "%s%s", bib, suffixes[k] );
+				for ( start=0; start<strlen( s ); ++start )
+					check( s, start );
+			}
+		}
+	}
+
+	srand( 3 );
+	for ( i=0; i<100000; ++i ) {
+		n = 1 + rand() % 14;
+		for ( k=0; k<n; ++k )
+			s[k] = alphabet[ rand() % ( sizeof( alphabet ) - 1 ) ];
+		s[n] = '\0';
+		check( s, 0 );
+	}
+
+	if ( nfailed )
+		fprintf( stderr, "latex-trie: %d of %d differ\n", nfailed, ntests );
+	return nfailed!=0;
+}